@@ -12,6 +12,7 @@
 #include "ir/ir.h"
 #include "shared/error.h"
 #include "shared/timer.h"
+#include "shared/server.h"
 #include "parser/lexer.h"
 #include "parser/parser.h"
 #include "genllvm/genllvm.h"
@@ -56,35 +57,27 @@ void doAnalysis(ModuleNode **mod) {
     inodeTypeCheckAny(&tstate, (INode**)mod);
 }
 
-int main(int argc, char **argv) {
-    ConeOptions coneopt;
+// Compile the program named by the options: parse, analyze and generate code for it.
+// coremod is the core library, if already parsed for pointers of ptrsize bits, or NULL.
+// Return the exit code.
+int conecCompile(ConeOptions *coneopt, ModuleNode *coremod, int ptrsize) {
     GenState gen;
     ModuleNode *modnode;
-    int ok;
-
-    // Get compiler's options from passed arguments
-    ok = coneOptSet(&coneopt, &argc, argv);
-    if (ok <= 0)
-        exit(ok == 0 ? 0 : ExitOpts);
-    if (argc < 2)
-        errorExit(ExitOpts, "Specify a Cone program to compile.");
-    coneopt.srcpath = argv[1];
-    coneopt.srcname = fileName(coneopt.srcpath);
 
     // We set up generation early because we need target info, e.g.: pointer size
     timerBegin(SetupTimer);
-    genSetup(&gen, &coneopt);
+    genSetup(&gen, coneopt);
 
     // Parse source file, do semantic analysis, and generate code
     timerBegin(ParseTimer);
-    modnode = parsePgm(&coneopt);
+    modnode = parsePgm(coneopt, coneopt->ptrsize == ptrsize ? coremod : NULL);
     if (errors == 0) {
         timerBegin(SemTimer);
         doAnalysis(&modnode);
         if (errors == 0) {
             timerBegin(GenTimer);
-            if (coneopt.print_ir)
-                inodePrint(coneopt.output, coneopt.srcpath, (INode*)modnode);
+            if (coneopt->print_ir)
+                inodePrint(coneopt->output, coneopt->srcpath, (INode*)modnode);
             genmod(&gen, modnode);
             genClose(&gen);
         }
@@ -92,10 +85,60 @@ int main(int argc, char **argv) {
     timerBegin(TimerCount);
 
     // Close up everything necessary
-    if (coneopt.verbosity > 0)
+    if (coneopt->verbosity > 0)
         timerPrint();
     errorSummary();
+    if (coneopt->run)
+        return genRun(&gen);
+    return ExitSuccess;
+}
+
+// A compile server's core library, parsed once for pointers of serveptrsize bits
+static ModuleNode *servecoremod;
+static int serveptrsize;
+
+// Compile one request for the compile server, in a process of its own
+static int conecServe(int argc, char **argv) {
+    ConeOptions coneopt;
+    timerReset();
+    int ok = coneOptSet(&coneopt, &argc, argv);
+    if (ok <= 0)
+        return ok == 0 ? ExitSuccess : ExitOpts;
+    if (coneopt.serve)
+        errorExit(ExitOpts, "A compile server cannot be started by a compile request.");
+    if (argc < 2)
+        errorExit(ExitOpts, "Specify a Cone program to compile.");
+    coneopt.srcpath = argv[1];
+    coneopt.srcname = fileName(coneopt.srcpath);
+    return conecCompile(&coneopt, servecoremod, serveptrsize);
+}
+
+int main(int argc, char **argv) {
+    ConeOptions coneopt;
+    int ok;
+
+    // Get compiler's options from passed arguments
+    ok = coneOptSet(&coneopt, &argc, argv);
+    if (ok <= 0)
+        exit(ok == 0 ? 0 : ExitOpts);
+
+    // As a compile server, set up LLVM's targets and parse the core library,
+    // then compile each request in a copy of this process
+    if (coneopt.serve) {
+        serveptrsize = coneopt.ptrsize = genPrepare(&coneopt);
+        if (!serveptrsize)
+            exit(ExitOpts);
+        servecoremod = parseCorelib(&coneopt);
+        return serverRun(coneopt.serve, conecServe);
+    }
+
+    if (argc < 2)
+        errorExit(ExitOpts, "Specify a Cone program to compile.");
+    coneopt.srcpath = argv[1];
+    coneopt.srcname = fileName(coneopt.srcpath);
+    ok = conecCompile(&coneopt, NULL, 0);
 #ifdef _DEBUG
     getchar();    // Hack for VS debugging
 #endif
+    return ok;
 }
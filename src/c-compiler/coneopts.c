@@ -19,10 +19,12 @@ enum
     OPT_VERSION,
     OPT_HELP,
     OPT_DEBUG,
+    OPT_OPTLEVEL,
     OPT_BUILDFLAG,
     OPT_STRIP,
     OPT_PATHS,
     OPT_OUTPUT,
+    OPT_RUN,
     OPT_LIBRARY,
     OPT_RUNTIMEBC,
     OPT_PIC,
@@ -38,6 +40,10 @@ enum
     OPT_STATS,
     OPT_LINK_ARCH,
     OPT_LINKER,
+    OPT_JOBS,
+    OPT_CACHE,
+    OPT_INCREMENTAL,
+    OPT_SERVE,
 
     OPT_VERBOSE,
     OPT_IR,
@@ -63,10 +69,12 @@ static opt_arg_t args[] =
     { "version", 'v', OPT_ARG_NONE, OPT_VERSION },
     { "help", 'h', OPT_ARG_NONE, OPT_HELP },
     { "debug", 'd', OPT_ARG_NONE, OPT_DEBUG },
+    { "optimize", 'O', OPT_ARG_REQUIRED, OPT_OPTLEVEL },
     { "define", 'D', OPT_ARG_REQUIRED, OPT_BUILDFLAG },
     { "strip", 's', OPT_ARG_NONE, OPT_STRIP },
     { "path", 'p', OPT_ARG_REQUIRED, OPT_PATHS },
     { "output", 'o', OPT_ARG_REQUIRED, OPT_OUTPUT },
+    { "run", 'r', OPT_ARG_NONE, OPT_RUN },
     { "library", 'l', OPT_ARG_NONE, OPT_LIBRARY },
     { "runtimebc", '\0', OPT_ARG_NONE, OPT_RUNTIMEBC },
     { "pic", '\0', OPT_ARG_NONE, OPT_PIC },
@@ -82,6 +90,10 @@ static opt_arg_t args[] =
     { "stats", '\0', OPT_ARG_NONE, OPT_STATS },
     { "link-arch", '\0', OPT_ARG_REQUIRED, OPT_LINK_ARCH },
     { "linker", '\0', OPT_ARG_REQUIRED, OPT_LINKER },
+    { "jobs", 'j', OPT_ARG_REQUIRED, OPT_JOBS },
+    { "cache", '\0', OPT_ARG_REQUIRED, OPT_CACHE },
+    { "incremental", 'i', OPT_ARG_NONE, OPT_INCREMENTAL },
+    { "serve", '\0', OPT_ARG_REQUIRED, OPT_SERVE },
 
     { "verbose", 'V', OPT_ARG_REQUIRED, OPT_VERBOSE },
     { "ir", '\0', OPT_ARG_NONE, OPT_IR },
@@ -111,6 +123,13 @@ static void usage()
         "  --version, -v   Print the version of the compiler and exit.\n"
         "  --help, -h      Print this help text and exit.\n"
         "  --debug, -d     Don't optimise the output.\n"
+        "  --optimize, -O  Optimization level.\n"
+        "    =0            No optimization. The default with --debug.\n"
+        "    =1            Light optimization, without inlining.\n"
+        "    =2            Full optimization, with vectorization. The default.\n"
+        "    =3            Also more aggressive inlining and code generation.\n"
+        "    =s            Like 2, but favor smaller code.\n"
+        "    =z            Like s, but smaller still, without vectorization.\n"
         "  --define, -D    Define the specified build flag.\n"
         "    =name\n"
         "  --strip, -s     Strip debug info.\n"
@@ -118,6 +137,8 @@ static void usage()
         "    =path         Used to find packages and libraries.\n"
         "  --output, -o    Write output to this directory.\n"
         "    =path         Defaults to the current directory.\n"
+        "  --run, -r       Compile in memory and run the program's main function.\n"
+        "                  Its result becomes the exit code. No files are written.\n"
         "  --library, -l   Generate a C-API compatible static library.\n"
         "  --runtimebc     Compile with the LLVM bitcode file for the runtime.\n"
         "  --wasm          Compile for WebAssembly target.\n"
@@ -130,10 +151,11 @@ static void usage()
         "  --safe          Allow only the listed packages to use C FFI.\n"
         "    =package      With no packages listed, only builtin is allowed.\n"
         "  --cpu           Set the target CPU.\n"
-        "    =name         Default is the host CPU.\n"
+        "    =name         Default is generic, which runs on any CPU of the triple.\n"
+        "    =native       The host's CPU, with all of its features.\n"
         "  --features      CPU features to enable or disable.\n"
         "    =+this,-that  Use + to enable, - to disable.\n"
-        "                  Defaults to detecting all CPU features from the host.\n"
+        "                  Defaults to none beyond the CPU's own.\n"
         "  --triple        Set the target triple.\n"
         "    =name         Defaults to the host triple.\n"
         "  --stats         Print some compiler stats.\n"
@@ -141,6 +163,19 @@ static void usage()
         "    =name         Default is the host architecture.\n"
         "  --linker        Set the linker command to use.\n"
         "    =name         Default is the compiler.\n"
+        "  --jobs, -j      Optimize and generate code on this many threads.\n"
+        "    =N            Default is 1. Partition k>0 is written as <name>.k.o,\n"
+        "                  to be linked along with <name>.o.\n"
+        "  --cache         Reuse objects generated before for the same LLVM IR.\n"
+        "    =path         Directory holding the cached objects.\n"
+        "  --incremental, -i\n"
+        "                  Recompile only functions changed since the last build.\n"
+        "                  Functions are grouped into units, written as <name>.k.o.\n"
+        "                  Unchanged units are copied from the --cache directory\n"
+        "                  (default .conecache). No inlining is done across units.\n"
+        "  --serve         Run as a compile server, for the conecc client.\n"
+        "    =socket       Unix domain socket to accept compile requests on.\n"
+        "                  Target options given here are set up ahead of requests.\n"
         ,
         "Debugging options:\n"
         "  --verbose, -V   Verbosity level.\n"
@@ -184,6 +219,8 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
     opt.pic = 1;
 #endif
     opt->release = 1;
+    opt->optlevel = -1;
+    opt->jobs = 1;
 
     while ((id = optNext(&s)) != -1) {
         switch (id) {
@@ -196,8 +233,23 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
             return 0;
 
         case OPT_DEBUG: opt->release = 0; break;
+        case OPT_OPTLEVEL:
+        {
+            char *level = s.arg_val;
+            opt->sizelevel = 0;
+            if (level[0] >= '0' && level[0] <= '3' && level[1] == '\0')
+                opt->optlevel = level[0] - '0';
+            else if ((level[0] == 's' || level[0] == 'z') && level[1] == '\0') {
+                opt->optlevel = 2;
+                opt->sizelevel = level[0] == 's' ? 1 : 2;
+            }
+            else
+                ok = 0;
+        }
+        break;
         case OPT_STRIP: opt->strip_debug = 1; break;
         case OPT_OUTPUT: opt->output = s.arg_val; break;
+        case OPT_RUN: opt->run = 1; break;
         case OPT_LIBRARY: opt->library = 1; break;
         case OPT_RUNTIMEBC: opt->runtimebc = 1; break;
         case OPT_PIC: opt->pic = 1; break;
@@ -232,6 +284,18 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
         case OPT_STATS: opt->print_stats = 1; break;
         case OPT_LINK_ARCH: opt->link_arch = s.arg_val; break;
         case OPT_LINKER: opt->linker = s.arg_val; break;
+        case OPT_CACHE: opt->cache = s.arg_val; break;
+        case OPT_INCREMENTAL: opt->incremental = 1; break;
+        case OPT_SERVE: opt->serve = s.arg_val; break;
+        case OPT_JOBS:
+        {
+            int n = atoi(s.arg_val);
+            if (n >= 1)
+                opt->jobs = n;
+            else
+                ok = 0;
+        }
+        break;
 
         case OPT_IR: opt->print_ir = 1; break;
         case OPT_ASM: opt->print_asm = 1; break;
@@ -274,6 +338,10 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
             usage();
         return -1;
     }
+    if (opt->optlevel < 0)
+        opt->optlevel = opt->release ? 2 : 0;
+    if (opt->incremental && !opt->cache)
+        opt->cache = ".conecache";
     return 1;
 }
 
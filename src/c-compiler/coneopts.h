@@ -28,17 +28,24 @@ typedef struct ConeOptions {
     char* triple;
     char* cpu;
     char* features;
+    char* cache;      // Object cache directory, or NULL for none
+    char* serve;      // Socket path to serve compile requests on, or NULL
 
     //typecheck_t check;
 
     void* data; // User-defined data for unit test callbacks
 
     int ptrsize;    // Size of a pointer (in bits)
+    int jobs;       // Number of threads for optimization and code generation
 
     // Boolean flags
     int wasm;        // 1=WebAssembly
     int release;    // 0=debug (no optimizations). 1=release (default)
+    int optlevel;   // 0-3, as in -O0 to -O3 (default 2, or 0 with --debug)
+    int sizelevel;  // 0=speed, 1=favor size (-Os), 2=smallest (-Oz)
     int library;    // 1=generate a C-API compatible static library
+    int run;        // 1=JIT-compile and run the program, rather than write objects
+    int incremental;    // 1=compile only the units of functions not in the object cache
     int runtimebc;    // Compile with the LLVM bitcode file for the runtime
     int pic;        // Compile using position independent code
     int print_stats;    // Print some compiler statistics
@@ -33,6 +33,7 @@ AllocNode *newRegionNodeStr(char *name) {
     newNode(allocnode, AllocNode, RegionTag);
     Name *namesym = nametblFind(name, strlen(name));
     allocnode->namesym = namesym;
+    iNsTypeInit((INsTypeNode*)allocnode, 1);  // No methods: the generator knows how to allocate from it
     namesym->node = (INode*)allocnode;
     return allocnode;
 }
@@ -40,6 +41,8 @@ AllocNode *newRegionNodeStr(char *name) {
 void stdRegionInit() {
     soRegion = newRegionNodeStr("so");
     rcRegion = newRegionNodeStr("rc");
+    arenaRegion = newRegionNodeStr("arena");
+    poolRegion = newRegionNodeStr("pool");
 }
 
 char *corelib =
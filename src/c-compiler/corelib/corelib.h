@@ -29,6 +29,8 @@ LifetimeNode *staticLifetimeNode;
 // Built-in allocator types
 AllocNode *soRegion;
 AllocNode *rcRegion;
+AllocNode *arenaRegion;  // Bump allocated, released all at once (conestd/region.c)
+AllocNode *poolRegion;   // Owned, like so, but recycled through per-size free lists
 
 // Primitive numeric types - for implicit (nondeclared but known) types
 NbrNode *boolType;    // i1
@@ -27,6 +27,24 @@
 LLVMValueRef genlmallocval = NULL;
 LLVMValueRef genlfreeval = NULL;
 
+// Declarations of the arena and pool regions' runtime (conestd/region.c)
+LLVMValueRef genlarenanextval = NULL;
+LLVMValueRef genlarenalimitval = NULL;
+LLVMValueRef genlarenagrowval = NULL;
+LLVMValueRef genlpoolfreeval = NULL;
+LLVMValueRef genlpoolrefillval = NULL;
+LLVMValueRef genlarenaallocval = NULL;
+LLVMValueRef genlpoolallocval = NULL;
+LLVMValueRef genlpooldropval = NULL;
+
+// Keep in step with conestd/region.c
+#define GenlRegionAlign 16
+#define GenlPoolMaxSize 256
+
+// Largest value (in bytes) that an own allocation which does not escape puts on the stack.
+// Bigger ones stay on the heap, so deep recursion does not overflow the stack.
+#define GenlStackAllocMax 256
+
 // Call malloc() (and generate declaration if needed)
 LLVMValueRef genlmalloc(GenState *gen, long long size) {
     // Declare malloc() external function
@@ -51,10 +69,11 @@ void genlDealiasFlds(GenState *gen, LLVMValueRef ref, RefNode *refnode) {
     for (nodelistFor(&strnode->fields, cnt, nodesp)) {
         FieldDclNode *field = (FieldDclNode *)*nodesp;
         RefNode *vartype = (RefNode *)field->vtype;
-        if (vartype->tag != RefTag || !(vartype->region == (INode*)rcRegion || vartype->region == (INode*)soRegion))
+        if (vartype->tag != RefTag || !(regionCounts(vartype->region) || regionFrees(vartype->region)))
             continue;
-        LLVMValueRef fldref = LLVMBuildStructGEP(gen->builder, ref, field->index, &field->namesym->namestr);
-        if (vartype->region == (INode*)soRegion)
+        LLVMValueRef fldptr = LLVMBuildStructGEP(gen->builder, ref, field->index, "");
+        LLVMValueRef fldref = LLVMBuildLoad(gen->builder, fldptr, &field->namesym->namestr);
+        if (!regionCounts(vartype->region))
             genlDealiasOwn(gen, fldref, vartype);
         else
             genlRcCounter(gen, fldref, -1, vartype);
@@ -75,33 +94,215 @@ LLVMValueRef genlFree(GenState *gen, LLVMValueRef ref) {
     return LLVMBuildCall(gen->builder, genlfreeval, &refcast, 1, "");
 }
 
+// Declare one of the region runtime's thread-local globals (if not already)
+static LLVMValueRef genlRegionGlobal(GenState *gen, LLVMValueRef *globalp, LLVMTypeRef type, char *name) {
+    if (*globalp == NULL) {
+        *globalp = LLVMAddGlobal(gen->module, type, name);
+        LLVMSetThreadLocal(*globalp, 1);
+    }
+    return *globalp;
+}
+
+// Call one of the region runtime's slow paths, which take a usize and return *u8
+static LLVMValueRef genlRegionCall(GenState *gen, LLVMValueRef *fnp, char *name, long long arg) {
+    LLVMTypeRef usize = genlUsize(gen);
+    if (*fnp == NULL) {
+        LLVMTypeRef rettype = LLVMPointerType(LLVMInt8TypeInContext(gen->context), 0);
+        *fnp = LLVMAddFunction(gen->module, name, LLVMFunctionType(rettype, &usize, 1, 0));
+    }
+    LLVMValueRef argval = LLVMConstInt(usize, arg, 0);
+    return LLVMBuildCall(gen->builder, *fnp, &argval, 1, "");
+}
+
+// Join a fast path's and a slow path's allocated memory (*u8)
+static LLVMValueRef genlRegionJoin(GenState *gen, LLVMValueRef fastval, LLVMBasicBlockRef fastblk,
+    LLVMValueRef slowval, LLVMBasicBlockRef slowblk, LLVMBasicBlockRef joinblk) {
+    LLVMPositionBuilderAtEnd(gen->builder, joinblk);
+    LLVMValueRef phi = LLVMBuildPhi(gen->builder, LLVMTypeOf(fastval), "allocmem");
+    LLVMValueRef vals[2] = { fastval, slowval };
+    LLVMBasicBlockRef blks[2] = { fastblk, slowblk };
+    LLVMAddIncoming(phi, vals, blks, 2);
+    return phi;
+}
+
+// Bump allocate from the arena, calling coneArenaGrow() when its chunk is full.
+// Code run by the JIT (--run) cannot reach the runtime's thread-local state,
+// so there every arena and pool allocation and free is a call.
+static LLVMValueRef genlArenaAlloc(GenState *gen, long long size) {
+    size = (size + GenlRegionAlign - 1) & ~(GenlRegionAlign - 1);
+    if (gen->opt->run)
+        return genlRegionCall(gen, &genlarenaallocval, "coneArenaAlloc", size);
+    LLVMTypeRef ptru8 = LLVMPointerType(LLVMInt8TypeInContext(gen->context), 0);
+    LLVMTypeRef usize = genlUsize(gen);
+    LLVMValueRef nextp = genlRegionGlobal(gen, &genlarenanextval, ptru8, "coneArenaNext");
+    LLVMValueRef limitp = genlRegionGlobal(gen, &genlarenalimitval, ptru8, "coneArenaLimit");
+
+    LLVMValueRef next = LLVMBuildLoad(gen->builder, nextp, "arenanext");
+    LLVMValueRef sizeval = LLVMConstInt(usize, size, 0);
+    LLVMValueRef newnext = LLVMBuildGEP(gen->builder, next, &sizeval, 1, "");
+    LLVMValueRef fits = LLVMBuildICmp(gen->builder, LLVMIntULE, LLVMBuildPtrToInt(gen->builder, newnext, usize, ""),
+        LLVMBuildPtrToInt(gen->builder, LLVMBuildLoad(gen->builder, limitp, "arenalimit"), usize, ""), "fits");
+    LLVMBasicBlockRef bumpblk = genlInsertBlock(gen, "arenabump");
+    LLVMBasicBlockRef growblk = genlInsertBlock(gen, "arenagrow");
+    LLVMBasicBlockRef joinblk = genlInsertBlock(gen, "arenaalloc");
+    genlBranchLikely(gen, LLVMBuildCondBr(gen->builder, fits, bumpblk, growblk));
+
+    LLVMPositionBuilderAtEnd(gen->builder, bumpblk);
+    LLVMBuildStore(gen->builder, newnext, nextp);
+    LLVMBuildBr(gen->builder, joinblk);
+    LLVMPositionBuilderAtEnd(gen->builder, growblk);
+    LLVMValueRef grown = genlRegionCall(gen, &genlarenagrowval, "coneArenaGrow", size);
+    LLVMBuildBr(gen->builder, joinblk);
+    return genlRegionJoin(gen, next, bumpblk, grown, growblk, joinblk);
+}
+
+// Return the size class of a pool allocation
+static long long genlPoolClass(long long size) {
+    return size <= GenlRegionAlign ? 0 : (size - 1) / GenlRegionAlign;
+}
+
+// Return the free list head (in conePoolFree) for a pool allocation's size class
+static LLVMValueRef genlPoolSlot(GenState *gen, long long size) {
+    LLVMTypeRef ptru8 = LLVMPointerType(LLVMInt8TypeInContext(gen->context), 0);
+    LLVMValueRef freelists = genlRegionGlobal(gen, &genlpoolfreeval,
+        LLVMArrayType(ptru8, GenlPoolMaxSize / GenlRegionAlign), "conePoolFree");
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(gen->context);
+    LLVMValueRef indexes[2];
+    indexes[0] = LLVMConstInt(i32, 0, 0);
+    indexes[1] = LLVMConstInt(i32, genlPoolClass(size), 0);
+    return LLVMBuildInBoundsGEP(gen->builder, freelists, indexes, 2, "poolslot");
+}
+
+// Pop a block off its size class's free list, calling conePoolRefill() when it is empty.
+// Values too big for any size class come from malloc().
+static LLVMValueRef genlPoolAlloc(GenState *gen, long long size) {
+    if (size > GenlPoolMaxSize)
+        return genlmalloc(gen, size);
+    if (gen->opt->run)
+        return genlRegionCall(gen, &genlpoolallocval, "conePoolAlloc", genlPoolClass(size));
+    LLVMTypeRef ptru8 = LLVMPointerType(LLVMInt8TypeInContext(gen->context), 0);
+    LLVMValueRef slot = genlPoolSlot(gen, size);
+    LLVMValueRef head = LLVMBuildLoad(gen->builder, slot, "poolhead");
+    LLVMValueRef hasblk = LLVMBuildIsNotNull(gen->builder, head, "");
+    LLVMBasicBlockRef popblk = genlInsertBlock(gen, "poolpop");
+    LLVMBasicBlockRef refillblk = genlInsertBlock(gen, "poolrefill");
+    LLVMBasicBlockRef joinblk = genlInsertBlock(gen, "poolalloc");
+    genlBranchLikely(gen, LLVMBuildCondBr(gen->builder, hasblk, popblk, refillblk));
+
+    LLVMPositionBuilderAtEnd(gen->builder, popblk);
+    LLVMValueRef link = LLVMBuildBitCast(gen->builder, head, LLVMPointerType(ptru8, 0), "");
+    LLVMBuildStore(gen->builder, LLVMBuildLoad(gen->builder, link, ""), slot);
+    LLVMBuildBr(gen->builder, joinblk);
+    LLVMPositionBuilderAtEnd(gen->builder, refillblk);
+    LLVMValueRef refilled = genlRegionCall(gen, &genlpoolrefillval, "conePoolRefill", genlPoolClass(size));
+    LLVMBuildBr(gen->builder, joinblk);
+    return genlRegionJoin(gen, head, popblk, refilled, refillblk, joinblk);
+}
+
+// Push a pool reference's block back onto its size class's free list
+static void genlPoolFree(GenState *gen, LLVMValueRef ref, long long size) {
+    if (size > GenlPoolMaxSize) {
+        genlFree(gen, ref);
+        return;
+    }
+    LLVMTypeRef ptru8 = LLVMPointerType(LLVMInt8TypeInContext(gen->context), 0);
+    if (gen->opt->run) {
+        LLVMTypeRef parmtypes[2] = { ptru8, genlUsize(gen) };
+        if (genlpooldropval == NULL)
+            genlpooldropval = LLVMAddFunction(gen->module, "conePoolDrop",
+                LLVMFunctionType(LLVMVoidTypeInContext(gen->context), parmtypes, 2, 0));
+        LLVMValueRef args[2];
+        args[0] = LLVMBuildBitCast(gen->builder, ref, ptru8, "");
+        args[1] = LLVMConstInt(parmtypes[1], genlPoolClass(size), 0);
+        LLVMBuildCall(gen->builder, genlpooldropval, args, 2, "");
+        return;
+    }
+    LLVMValueRef slot = genlPoolSlot(gen, size);
+    LLVMValueRef link = LLVMBuildBitCast(gen->builder, ref, LLVMPointerType(ptru8, 0), "");
+    LLVMBuildStore(gen->builder, LLVMBuildLoad(gen->builder, slot, "poolhead"), link);
+    LLVMBuildStore(gen->builder, LLVMBuildBitCast(gen->builder, ref, ptru8, ""), slot);
+}
+
+// Get a declared region's method, generating the region's methods if not yet done
+static LLVMValueRef genlRegionFn(GenState *gen, INode *region, FnDclNode *fn) {
+    if (fn->llvmvar == NULL)
+        genlType(gen, region);
+    return fn->llvmvar;
+}
+
+// Call a declared region's alloc method for size bytes
+static LLVMValueRef genlRegionAlloc(GenState *gen, INode *region, FnDclNode *allocfn, long long size) {
+    LLVMValueRef fn = genlRegionFn(gen, region, allocfn);
+    FnSigNode *sig = (FnSigNode*)allocfn->vtype;
+    LLVMValueRef sizeval = LLVMConstInt(genlType(gen, ((IExpNode*)nodesGet(sig->parms, 0))->vtype), size, 0);
+    return LLVMBuildCall(gen->builder, fn, &sizeval, 1, "");
+}
+
+// Call a declared region's free method on a reference
+static void genlRegionFree(GenState *gen, INode *region, FnDclNode *freefn, LLVMValueRef ref) {
+    LLVMValueRef fn = genlRegionFn(gen, region, freefn);
+    FnSigNode *sig = (FnSigNode*)freefn->vtype;
+    LLVMValueRef ptr = LLVMBuildBitCast(gen->builder, ref, genlType(gen, ((IExpNode*)nodesGet(sig->parms, 0))->vtype), "");
+    LLVMBuildCall(gen->builder, fn, &ptr, 1, "");
+}
+
+// Does a variable's initial value allocate its value on the stack?
+// Flow analysis marks allocations that do not escape, and only small values go there.
+static int genlStackAlloc(GenState *gen, INode *value) {
+    if (value == NULL || value->tag != AllocateTag || !(value->flags & FlagStackAlloc))
+        return 0;
+    RefNode *reftype = (RefNode*)((AllocateNode*)value)->vtype;
+    return LLVMABISizeOfType(gen->datalayout, genlType(gen, reftype->pvtype)) <= GenlStackAllocMax;
+}
+
 // Generate code that creates an allocated ref by allocating and initializing
 LLVMValueRef genlallocref(GenState *gen, AllocateNode *allocatenode) {
     RefNode *reftype = (RefNode*)allocatenode->vtype;
+    if (genlStackAlloc(gen, (INode*)allocatenode)) {
+        LLVMValueRef valptr = genlAlloca(gen, genlType(gen, reftype->pvtype), "");
+        LLVMBuildStore(gen->builder, genlExpr(gen, allocatenode->exp), valptr);
+        return LLVMBuildBitCast(gen->builder, valptr, genlType(gen, allocatenode->vtype), "");
+    }
     long long valsize = LLVMABISizeOfType(gen->datalayout, genlType(gen, reftype->pvtype));
     long long allocsize = 0;
-    if (reftype->region == (INode*)rcRegion)
+    if (regionCounts(reftype->region))
         allocsize = LLVMABISizeOfType(gen->datalayout, genlType(gen, (INode*)usizeType));
-    LLVMValueRef malloc = genlmalloc(gen, allocsize + valsize);
-    if (reftype->region == (INode*)rcRegion) {
+    LLVMValueRef malloc;
+    FnDclNode *allocfn = regionFindFn(reftype->region, allocName);
+    if (allocfn)
+        malloc = genlRegionAlloc(gen, reftype->region, allocfn, allocsize + valsize);
+    else if (reftype->region == (INode*)arenaRegion)
+        malloc = genlArenaAlloc(gen, valsize);
+    else if (reftype->region == (INode*)poolRegion)
+        malloc = genlPoolAlloc(gen, valsize);
+    else
+        malloc = genlmalloc(gen, allocsize + valsize);
+    if (regionCounts(reftype->region)) {
         LLVMValueRef constone = LLVMConstInt(genlType(gen, (INode*)usizeType), 1, 0);
         LLVMTypeRef ptrusize = LLVMPointerType(genlType(gen, (INode*)usizeType), 0);
         LLVMValueRef counterptr = LLVMBuildBitCast(gen->builder, malloc, ptrusize, "");
         LLVMBuildStore(gen->builder, constone, counterptr); // Store 1 into refcounter
-        malloc = LLVMBuildGEP(gen->builder, malloc, &constone, 1, ""); // Point to value
+        malloc = LLVMBuildGEP(gen->builder, counterptr, &constone, 1, ""); // Point to value, after refcounter
     }
     LLVMValueRef valcast = LLVMBuildBitCast(gen->builder, malloc, genlType(gen, allocatenode->vtype), "");
     LLVMBuildStore(gen->builder, genlExpr(gen, allocatenode->exp), valcast);
     return valcast;
 }
 
-// Dealias an own allocated reference
+// Dealias an own allocated reference (so, pool or a declared region with free)
 void genlDealiasOwn(GenState *gen, LLVMValueRef ref, RefNode *refnode) {
     genlDealiasFlds(gen, ref, refnode);
-    genlFree(gen, ref);
+    FnDclNode *freefn = regionFindFn(refnode->region, freeName);
+    if (freefn)
+        genlRegionFree(gen, refnode->region, freefn, ref);
+    else if (refnode->region == (INode*)poolRegion)
+        genlPoolFree(gen, ref, LLVMABISizeOfType(gen->datalayout, genlType(gen, refnode->pvtype)));
+    else
+        genlFree(gen, ref);
 }
 
-// Add to the counter of an rc allocated reference
+// Add to the counter of an rc allocated reference (rc, or a region declared on rc).
+// When it reaches zero, the counter and value are freed together, by the region's free if it has one.
 void genlRcCounter(GenState *gen, LLVMValueRef ref, long long amount, RefNode *refnode) {
     // Point backwards to ref counter
     LLVMTypeRef ptrusize = LLVMPointerType(genlType(gen, (INode*)usizeType), 0);
@@ -123,12 +324,31 @@ void genlRcCounter(GenState *gen, LLVMValueRef ref, long long amount, RefNode *r
         LLVMBuildCondBr(gen->builder, test, dofree, nofree);
         LLVMPositionBuilderAtEnd(gen->builder, dofree);
         genlDealiasFlds(gen, ref, refnode);
-        genlFree(gen, cntptr);
+        FnDclNode *freefn = regionFindFn(refnode->region, freeName);
+        if (freefn)
+            genlRegionFree(gen, refnode->region, freefn, cntptr);
+        else
+            genlFree(gen, cntptr);
         LLVMBuildBr(gen->builder, nofree);
         LLVMPositionBuilderAtEnd(gen->builder, nofree);
     }
 }
 
+// Declare a VarDropFlag variable's flag, as it is declared (no-op for other variables)
+void genlDropFlagDcl(GenState *gen, VarDclNode *var, int live) {
+    var->llvmdropflag = NULL;
+    if (!(var->flowflags & VarDropFlag))
+        return;
+    var->llvmdropflag = genlAlloca(gen, LLVMInt1TypeInContext(gen->context), "dropflag");
+    genlDropFlag(gen, var, live);
+}
+
+// Record whether a VarDropFlag variable has a value to drop (no-op for other variables)
+void genlDropFlag(GenState *gen, VarDclNode *var, int live) {
+    if (var->llvmdropflag)
+        LLVMBuildStore(gen->builder, LLVMConstInt(LLVMInt1TypeInContext(gen->context), live, 0), var->llvmdropflag);
+}
+
 // Progressively dealias or drop all declared variables in nodes list
 void genlDealiasNodes(GenState *gen, Nodes *nodes) {
     if (nodes == NULL)
@@ -139,13 +359,30 @@ void genlDealiasNodes(GenState *gen, Nodes *nodes) {
         VarDclNode *var = (VarDclNode *)*nodesp;
         RefNode *reftype = (RefNode *)var->vtype;
         if (reftype->tag == RefTag) {
+            // A variable moved on some paths only is dropped only if its flag says it still has its value
+            LLVMBasicBlockRef dropped = NULL;
+            if (var->llvmdropflag) {
+                LLVMBasicBlockRef dodrop = genlInsertBlock(gen, "drop");
+                dropped = genlInsertBlock(gen, "dropped");
+                LLVMValueRef live = LLVMBuildLoad(gen->builder, var->llvmdropflag, "");
+                LLVMBuildCondBr(gen->builder, live, dodrop, dropped);
+                LLVMPositionBuilderAtEnd(gen->builder, dodrop);
+            }
             LLVMValueRef ref = LLVMBuildLoad(gen->builder, var->llvmvar, "allocref");
-            if (reftype->region == (INode*)soRegion) {
-                genlDealiasOwn(gen, ref, reftype);
+            if (regionFrees(reftype->region)) {
+                // A stack-allocated value has nothing to free but its fields
+                if (genlStackAlloc(gen, var->value))
+                    genlDealiasFlds(gen, ref, reftype);
+                else
+                    genlDealiasOwn(gen, ref, reftype);
             }
-            else if (reftype->region == (INode*)rcRegion) {
+            else if (regionCounts(reftype->region)) {
                 genlRcCounter(gen, ref, -1, reftype);
             }
+            if (dropped) {
+                LLVMBuildBr(gen->builder, dropped);
+                LLVMPositionBuilderAtEnd(gen->builder, dropped);
+            }
         }
     }
 }
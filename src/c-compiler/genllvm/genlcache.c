@@ -0,0 +1,93 @@
+/** Object cache: reuse objects already generated for identical LLVM IR (--cache)
+ * @file
+ *
+ * Entries are keyed on a hash of the module's bitcode, as generated (before
+ * optimization), together with everything else that shapes the object made
+ * from it: LLVM's version, the target triple, CPU and features, and the
+ * optimization and relocation settings. On a hit, the cached object (and
+ * assembly, with --asm) is copied to the output directory, and the module is
+ * neither optimized nor compiled. On a miss, freshly emitted outputs are
+ * added to the cache. Entries are never evicted: the directory may be
+ * emptied at any time.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../ir/nametbl.h"
+#include "../shared/memory.h"
+#include "../shared/fileio.h"
+#include "../shared/timer.h"
+#include "../coneopts.h"
+#include "genllvm.h"
+
+#include <llvm-c/BitWriter.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define genlCacheMkdir(dir) _mkdir(dir)
+#define genlCachePid() _getpid()
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define genlCacheMkdir(dir) mkdir(dir, 0777)
+#define genlCachePid() getpid()
+#endif
+
+// Make a cache key from a hash and length of content to be compiled, together with
+// the settings that shape the object made from it
+char *genlCacheKeyOf(ConeOptions *opt, uint64_t hash, size_t len) {
+    char settings[512];
+    char key[64];
+
+    int setlen = snprintf(settings, sizeof(settings), "%d.%d|%s|%s|%s|O%d|s%d|%d|%d|%d|%d",
+        LLVM_VERSION_MAJOR, LLVM_VERSION_MINOR, opt->triple, opt->cpu, opt->features,
+        opt->optlevel, opt->sizelevel, opt->release, opt->pic, opt->library, opt->wasm);
+    if (setlen < 0 || (size_t)setlen >= sizeof(settings))
+        setlen = sizeof(settings) - 1;
+    snprintf(key, sizeof(key), "%016llx%016llx-%llx", (unsigned long long)hash,
+        (unsigned long long)nametblHash(settings, (size_t)setlen), (unsigned long long)len);
+    return memAllocStr(key, strlen(key));
+}
+
+// Make the cache key for the generated module: the file name, sans extension,
+// of its cache entries
+char *genlCacheKey(GenState *gen) {
+    LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(gen->module);
+    size_t bclen = LLVMGetBufferSize(bitcode);
+    uint64_t bchash = nametblHash((char*)LLVMGetBufferStart(bitcode), bclen);
+    LLVMDisposeMemoryBuffer(bitcode);
+    return genlCacheKeyOf(gen->opt, bchash, bclen);
+}
+
+// Copy the cached outputs for key to objpath and, if not NULL, asmpath.
+// Return 1 on a hit, or 0 if any is missing (from the cache), to be generated.
+int genlCacheGet(ConeOptions *opt, char *key, char *objpath, char *objext, char *asmpath, char *asmext) {
+    int hit = fileCopy(fileMakePath(opt->cache, key, objext), objpath)
+        && (!asmpath || fileCopy(fileMakePath(opt->cache, key, asmext), asmpath));
+    timerCount(hit ? CacheHitCounter : CacheMissCounter);
+    return hit;
+}
+
+// Add one freshly generated output to the cache. It is copied under a name
+// private to this process, then renamed, so other compiles never see it half-written.
+static void genlCachePutFile(ConeOptions *opt, char *key, char *path, char *ext) {
+    char tmpext[48];
+    snprintf(tmpext, sizeof(tmpext), "%s.%d.tmp", ext, (int)genlCachePid());
+    char *tmppath = fileMakePath(opt->cache, key, tmpext);
+    if (!fileCopy(path, tmppath) || rename(tmppath, fileMakePath(opt->cache, key, ext)) != 0)
+        remove(tmppath);
+}
+
+// Add the outputs generated for key to the cache, creating its directory if need be
+void genlCachePut(ConeOptions *opt, char *key, char *objpath, char *objext, char *asmpath, char *asmext) {
+    genlCacheMkdir(opt->cache);
+    genlCachePutFile(opt, key, objpath, objext);
+    if (asmpath)
+        genlCachePutFile(opt, key, asmpath, asmext);
+}
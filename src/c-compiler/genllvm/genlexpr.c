@@ -41,8 +41,8 @@ LLVMValueRef genlIf(GenState *gen, IfNode *ifnode) {
     count = ifnode->condblk->used / 2;
     i = phicnt = 0;
     if (vtype != unknownType) {
-        blkvals = memAllocBlk(count * sizeof(LLVMValueRef));
-        blks = memAllocBlk(count * sizeof(LLVMBasicBlockRef));
+        blkvals = memAllocTmp(count * sizeof(LLVMValueRef));
+        blks = memAllocTmp(count * sizeof(LLVMBasicBlockRef));
     }
 
     endif = genlInsertBlock(gen, "endif");
@@ -104,7 +104,7 @@ LLVMValueRef genlFnCall(GenState *gen, FnCallNode *fncall) {
 
     // Get Valuerefs for all the parameters to pass to the function
     LLVMValueRef fncallret = NULL;
-    LLVMValueRef *fnargs = (LLVMValueRef*)memAllocBlk(fncall->args->used * sizeof(LLVMValueRef*));
+    LLVMValueRef *fnargs = (LLVMValueRef*)memAllocTmp(fncall->args->used * sizeof(LLVMValueRef*));
     LLVMValueRef *fnarg = fnargs;
     INode **nodesp;
     uint32_t cnt;
@@ -602,6 +602,7 @@ LLVMValueRef genlLocalVar(GenState *gen, VarDclNode *var) {
         val = genlExpr(gen, var->value);
         LLVMBuildStore(gen->builder, val, var->llvmvar);
     }
+    genlDropFlagDcl(gen, var, var->value != NULL);
     return val;
 }
 
@@ -673,15 +674,37 @@ void genlPanic(GenState *gen) {
     LLVMBuildCall(gen->builder, fn, NULL, 0, "");
 }
 
-void genlBoundsCheck(GenState *gen, LLVMValueRef index, LLVMValueRef count) {
-    // Do runtime bounds check and panic
-    LLVMBasicBlockRef panicblk = genlInsertBlock(gen, "panic");
+// Mark a conditional branch as almost always taking its first (true) path
+void genlBranchLikely(GenState *gen, LLVMValueRef condbr) {
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(gen->context);
+    LLVMValueRef weights[3];
+    weights[0] = LLVMMDStringInContext(gen->context, "branch_weights", 14);
+    weights[1] = LLVMConstInt(i32, 2000, 0);
+    weights[2] = LLVMConstInt(i32, 1, 0);
+    LLVMSetMetadata(condbr, LLVMGetMDKindIDInContext(gen->context, "prof", 4),
+        LLVMMDNodeInContext(gen->context, weights, 3));
+}
+
+// Get the function's one, cold panic block, which all its failed bounds checks jump to
+static LLVMBasicBlockRef genlPanicBlock(GenState *gen) {
+    if (gen->panicblk == NULL) {
+        LLVMBasicBlockRef current = LLVMGetInsertBlock(gen->builder);
+        gen->panicblk = LLVMAppendBasicBlockInContext(gen->context, gen->fn, "panic");
+        LLVMPositionBuilderAtEnd(gen->builder, gen->panicblk);
+        genlPanic(gen);
+        LLVMBuildUnreachable(gen->builder);
+        LLVMPositionBuilderAtEnd(gen->builder, current);
+    }
+    return gen->panicblk;
+}
+
+// Do a runtime bounds check of an array index, unless it is known to be in bounds
+void genlBoundsCheck(GenState *gen, FnCallNode *indexnode, LLVMValueRef index, LLVMValueRef count) {
+    if (indexnode->flags & FlagInBounds)
+        return;
     LLVMBasicBlockRef boundsblk = genlInsertBlock(gen, "boundsok");
     LLVMValueRef compare = LLVMBuildICmp(gen->builder, LLVMIntULT, index, count, "");
-    LLVMBuildCondBr(gen->builder, compare, boundsblk, panicblk);
-    LLVMPositionBuilderAtEnd(gen->builder, panicblk);
-    genlPanic(gen);
-    LLVMBuildBr(gen->builder, boundsblk);
+    genlBranchLikely(gen, LLVMBuildCondBr(gen->builder, compare, boundsblk, genlPanicBlock(gen)));
     LLVMPositionBuilderAtEnd(gen->builder, boundsblk);
 }
 
@@ -704,7 +727,7 @@ LLVMValueRef genlAddr(GenState *gen, INode *lval) {
         case ArrayTag: {
             LLVMValueRef count = LLVMConstInt(genlUsize(gen), ((ArrayNode*)objtype)->size, 0);
             LLVMValueRef index = genlExpr(gen, nodesGet(fncall->args, 0));
-            genlBoundsCheck(gen, index, count);
+            genlBoundsCheck(gen, fncall, index, count);
             LLVMValueRef indexes[2];
             indexes[0] = LLVMConstInt(genlUsize(gen), 0, 0);
             indexes[1] = index;
@@ -714,7 +737,7 @@ LLVMValueRef genlAddr(GenState *gen, INode *lval) {
             LLVMValueRef arrref = genlExpr(gen, fncall->objfn);
             LLVMValueRef count = LLVMBuildExtractValue(gen->builder, arrref, 1, "count");
             LLVMValueRef index = genlExpr(gen, nodesGet(fncall->args, 0));
-            genlBoundsCheck(gen, index, count);
+            genlBoundsCheck(gen, fncall, index, count);
             LLVMValueRef sliceptr = LLVMBuildExtractValue(gen->builder, arrref, 0, "sliceptr");
             return LLVMBuildGEP(gen->builder, sliceptr, &index, 1, "");
         }
@@ -761,19 +784,44 @@ void genlStore(GenState *gen, INode *lval, LLVMValueRef rval) {
         return;
     LLVMValueRef lvalptr = genlAddr(gen, lval);
     RefNode *reftype = (RefNode *)((IExpNode*)lval)->vtype;
-    if (reftype->tag == RefTag && reftype->region == (INode*)rcRegion)
+    if (reftype->tag == RefTag && regionCounts(reftype->region))
         genlRcCounter(gen, LLVMBuildLoad(gen->builder, lvalptr, "dealiasref"), -1, reftype);
     LLVMBuildStore(gen->builder, rval, lvalptr);
+    if (lval->tag == VarNameUseTag && ((NameUseNode*)lval)->dclnode->tag == VarDclTag)
+        genlDropFlag(gen, (VarDclNode*)((NameUseNode*)lval)->dclnode, 1);
+}
+
+// Set the builder's debug location to a source location.
+// Most nodes are on the same line as the one before them, or at the same place:
+// the line found last is reused without searching, and an unchanged location is not set again.
+static void genlDebugLoc(GenState *gen, uint32_t srcloc) {
+    if (srcloc == gen->dbgsrcloc && gen->fn == gen->dbgfn)
+        return;
+    if (srcloc < gen->dbglinesrcloc || srcloc >= gen->dbglineend) {
+        SrcPos pos;
+        lexSrcPos(srcloc, &pos);
+        SrcFile *srcfile = pos.file;
+        gen->dbglinenbr = pos.linenbr;
+        gen->dbglinesrcloc = srcloc - (uint32_t)(pos.srcp - pos.linep);
+        gen->dbglineend = pos.linenbr < srcfile->nlines
+            ? srcfile->srcloc + srcfile->lines[pos.linenbr]
+            : gen->dbglinesrcloc + (uint32_t)strlen(pos.linep) + 1;
+    }
+    gen->dbgfn = gen->fn;
+    gen->dbgsrcloc = srcloc;
+    LLVMMetadataRef loc = LLVMDIBuilderCreateDebugLocation(gen->context,
+        gen->dbglinenbr, srcloc - gen->dbglinesrcloc, LLVMGetSubprogram(gen->fn), NULL);
+#if LLVM_VERSION_MAJOR >= 9
+    LLVMSetCurrentDebugLocation2(gen->builder, loc);  // Without first wrapping loc as a value
+#else
+    LLVMSetCurrentDebugLocation(gen->builder, LLVMMetadataAsValue(gen->context, loc));
+#endif
 }
 
 // Generate a term
 LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
-    if (!gen->opt->release && gen->fn) {
-        LLVMMetadataRef loc = LLVMDIBuilderCreateDebugLocation(gen->context, 
-            termnode->linenbr, termnode->srcp-termnode->linep, LLVMGetSubprogram(gen->fn), NULL);
-        LLVMValueRef val = LLVMMetadataAsValue(gen->context, loc);
-        LLVMSetCurrentDebugLocation(gen->builder, val);
-    }
+    if (!gen->opt->release && gen->fn)
+        genlDebugLoc(gen, termnode->srcloc);
     switch (termnode->tag) {
     case ULitTag:
         return LLVMConstInt(genlType(gen, ((ULitNode*)termnode)->vtype), ((ULitNode*)termnode)->uintlit, 0);
@@ -792,7 +840,7 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
         INode **nodesp;
         uint32_t cnt;
         if (littype->tag == ArrayTag) {
-            LLVMValueRef *values = (LLVMValueRef *)memAllocBlk(size * sizeof(LLVMValueRef *));
+            LLVMValueRef *values = (LLVMValueRef *)memAllocTmp(size * sizeof(LLVMValueRef *));
             LLVMValueRef *valuep = values;
             for (nodesFor(lit->args, cnt, nodesp))
                 *valuep++ = genlExpr(gen, *nodesp);
@@ -839,7 +887,10 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
     case VarNameUseTag:
     {
         VarDclNode *vardcl = (VarDclNode*)((NameUseNode *)termnode)->dclnode;
-        return LLVMBuildLoad(gen->builder, vardcl->llvmvar, &vardcl->namesym->namestr);
+        LLVMValueRef val = LLVMBuildLoad(gen->builder, vardcl->llvmvar, &vardcl->namesym->namestr);
+        if (termnode->flags & FlagMoveOut)
+            genlDropFlag(gen, vardcl, 0);
+        return val;
     }
     case AliasTag:
     {
@@ -847,7 +898,7 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
         LLVMValueRef val = genlExpr(gen, anode->exp);
         RefNode *reftype = (RefNode*)iexpGetTypeDcl(termnode);
         if (reftype->tag == RefTag) {
-            if (reftype->region == (INode*)soRegion)
+            if (!regionCounts(reftype->region))
                 genlDealiasOwn(gen, val, reftype);
             else
                 genlRcCounter(gen, val, anode->aliasamt, reftype);
@@ -862,7 +913,7 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
                 if (*countp != 0) {
                     reftype = (RefNode *)itypeGetTypeDcl(*nodesp);
                     LLVMValueRef strval = LLVMBuildExtractValue(gen->builder, val, index, "");
-                    if (reftype->region == (INode*)soRegion)
+                    if (!regionCounts(reftype->region))
                         genlDealiasOwn(gen, strval, reftype);
                     else
                         genlRcCounter(gen, strval, *countp, reftype);
@@ -882,7 +933,7 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
             case ArrayTag: {
                 LLVMValueRef count = LLVMConstInt(genlUsize(gen), ((ArrayNode*)objtype)->size, 0);
                 LLVMValueRef index = genlExpr(gen, nodesGet(fncall->args, 0));
-                genlBoundsCheck(gen, index, count);
+                genlBoundsCheck(gen, fncall, index, count);
                 LLVMValueRef indexes[2];
                 indexes[0] = LLVMConstInt(genlUsize(gen), 0, 0);
                 indexes[1] = index;
@@ -894,7 +945,7 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
                 LLVMValueRef arrref = genlExpr(gen, deref->exp);
                 LLVMValueRef count = LLVMBuildExtractValue(gen->builder, arrref, 1, "count");
                 LLVMValueRef index = genlExpr(gen, nodesGet(fncall->args, 0));
-                genlBoundsCheck(gen, index, count);
+                genlBoundsCheck(gen, fncall, index, count);
                 LLVMValueRef sliceptr = LLVMBuildExtractValue(gen->builder, arrref, 0, "sliceptr");
                 return LLVMBuildGEP(gen->builder, sliceptr, &index, 1, "");
             }
@@ -902,7 +953,7 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
                 LLVMValueRef arrref = genlExpr(gen, fncall->objfn);
                 LLVMValueRef count = LLVMBuildExtractValue(gen->builder, arrref, 1, "count");
                 LLVMValueRef index = genlExpr(gen, nodesGet(fncall->args, 0));
-                genlBoundsCheck(gen, index, count);
+                genlBoundsCheck(gen, fncall, index, count);
                 LLVMValueRef sliceptr = LLVMBuildExtractValue(gen->builder, arrref, 0, "sliceptr");
                 return LLVMBuildGEP(gen->builder, sliceptr, &index, 1, "");
             }
@@ -0,0 +1,189 @@
+/** In-process JIT: run the generated program without writing objects (--run)
+ * @file
+ *
+ * The optimized module is handed to LLVM's ORC JIT (LLJIT), main is looked up
+ * and called, and its return value becomes the compiler's exit code.
+ * The module is compiled as a whole when main is looked up.
+ * --run needs LLVM 12 or later, whose C API offers LLJIT.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../shared/error.h"
+#include "../coneopts.h"
+#include "genllvm.h"
+
+#include <llvm-c/Support.h>
+#if LLVM_VERSION_MAJOR >= 12
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Orc.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+static void *genlJitMain;     // Address of the program's main function
+static int genlJitMainInt;    // Does main return an integer (vs. nothing)?
+
+#if LLVM_VERSION_MAJOR >= 12
+
+// The conestd library's functions, linked into the compiler for programs it runs
+void print(char *p);
+void printInt(int64_t nbr);
+void printFloat(double nbr);
+void printChar(uint64_t code);
+void *coneArenaGrow(size_t size);
+void *coneArenaAlloc(size_t size);
+void coneArenaOpen();
+void coneArenaClose();
+void *conePoolRefill(size_t sizeclass);
+void *conePoolAlloc(size_t sizeclass);
+void conePoolDrop(void *blk, size_t sizeclass);
+
+typedef struct {
+    char *name;
+    void *addr;
+} GenJitSym;
+
+static GenJitSym genlJitSyms[] = {
+    {"print", (void*)print},
+    {"printInt", (void*)printInt},
+    {"printFloat", (void*)printFloat},
+    {"printChar", (void*)printChar},
+    {"coneArenaGrow", (void*)coneArenaGrow},
+    {"coneArenaAlloc", (void*)coneArenaAlloc},
+    {"coneArenaOpen", (void*)coneArenaOpen},
+    {"coneArenaClose", (void*)coneArenaClose},
+    {"conePoolRefill", (void*)conePoolRefill},
+    {"conePoolAlloc", (void*)conePoolAlloc},
+    {"conePoolDrop", (void*)conePoolDrop},
+};
+#define GenJitSymCnt (sizeof(genlJitSyms) / sizeof(GenJitSym))
+
+static LLVMOrcLLJITRef genlJitStack;
+
+// Report a failed JIT step, consuming its error
+static int genlJitFailed(LLVMErrorRef err, char *what) {
+    if (!err)
+        return 0;
+    char *msg = LLVMGetErrorMessage(err);
+    errorMsg(ErrorGenErr, "Could not %s: %s", what, msg);
+    LLVMDisposeErrorMessage(msg);
+    return 1;
+}
+
+// Add the conestd functions to the JIT's symbol table, as absolute addresses
+static int genlJitDefineSyms(LLVMOrcJITDylibRef dylib) {
+    LLVMJITCSymbolMapPair syms[GenJitSymCnt];
+    size_t i;
+    for (i = 0; i < GenJitSymCnt; ++i) {
+        syms[i].Name = LLVMOrcLLJITMangleAndIntern(genlJitStack, genlJitSyms[i].name);
+        syms[i].Sym.Address = (uint64_t)(uintptr_t)genlJitSyms[i].addr;
+        syms[i].Sym.Flags.GenericFlags = LLVMJITSymbolGenericFlagsExported;
+        syms[i].Sym.Flags.TargetFlags = 0;
+    }
+    return !genlJitFailed(LLVMOrcJITDylibDefine(dylib, LLVMOrcAbsoluteSymbols(syms, GenJitSymCnt)), "define conestd symbols");
+}
+
+// Hand the module to LLJIT and look up main, which compiles the module
+static int genlJitLoad(LLVMModuleRef mod, LLVMTargetMachineRef machine) {
+    LLVMOrcLLJITBuilderRef builder = LLVMOrcCreateLLJITBuilder();
+    LLVMOrcLLJITBuilderSetJITTargetMachineBuilder(builder, LLVMOrcJITTargetMachineBuilderCreateFromTargetMachine(machine));
+    if (genlJitFailed(LLVMOrcCreateLLJIT(&genlJitStack, builder), "create JIT")) {
+        LLVMDisposeModule(mod);
+        return 0;
+    }
+
+    // Resolve the conestd functions, then anything else (e.g., malloc) in the process
+    LLVMOrcJITDylibRef dylib = LLVMOrcLLJITGetMainJITDylib(genlJitStack);
+    LLVMOrcDefinitionGeneratorRef process;
+    if (!genlJitDefineSyms(dylib)
+        || genlJitFailed(LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(&process,
+            LLVMOrcLLJITGetGlobalPrefix(genlJitStack), NULL, NULL), "search process symbols")) {
+        LLVMDisposeModule(mod);
+        return 0;
+    }
+    LLVMOrcJITDylibAddGenerator(dylib, process);
+
+    // LLJIT needs the module in a context of its own, so it is moved over as bitcode
+    LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(mod);
+    LLVMDisposeModule(mod);
+    LLVMOrcThreadSafeContextRef tsctx = LLVMOrcCreateNewThreadSafeContext();
+    LLVMModuleRef jitmod;
+    int loaded = !LLVMParseBitcodeInContext2(LLVMOrcThreadSafeContextGetContext(tsctx), bitcode, &jitmod);
+    LLVMDisposeMemoryBuffer(bitcode);
+    if (!loaded) {
+        LLVMOrcDisposeThreadSafeContext(tsctx);
+        errorMsg(ErrorGenErr, "Could not load module into JIT");
+        return 0;
+    }
+    LLVMOrcThreadSafeModuleRef tsmod = LLVMOrcCreateNewThreadSafeModule(jitmod, tsctx);
+    LLVMOrcDisposeThreadSafeContext(tsctx);
+    if (genlJitFailed(LLVMOrcLLJITAddLLVMIRModule(genlJitStack, dylib, tsmod), "add module to JIT"))
+        return 0;
+
+    uint64_t addr;
+    if (genlJitFailed(LLVMOrcLLJITLookup(genlJitStack, &addr, "main"), "compile main"))
+        return 0;
+    genlJitMain = (void*)(uintptr_t)addr;
+    return 1;
+}
+
+static void genlJitDispose() {
+    genlJitFailed(LLVMOrcDisposeLLJIT(genlJitStack), "close JIT");
+}
+
+#else
+
+// Before LLVM 12, the C API has no LLJIT
+static int genlJitLoad(LLVMModuleRef mod, LLVMTargetMachineRef machine) {
+    errorMsg(ErrorGenErr, "--run needs a compiler built with LLVM 12 or later");
+    LLVMDisposeModule(mod);
+    LLVMDisposeTargetMachine(machine);
+    return 0;
+}
+
+static void genlJitDispose() {
+}
+
+#endif
+
+// Prepare the generated module to be run in-process. The module is consumed.
+// Compilation is done here, and running by genRun.
+void genlJit(GenState *gen) {
+    LLVMValueRef mainfn = LLVMGetNamedFunction(gen->module, "main");
+    if (!mainfn || LLVMIsDeclaration(mainfn)) {
+        errorMsg(ErrorGenErr, "The program needs a main function to be run");
+        LLVMDisposeModule(gen->module);
+        return;
+    }
+    LLVMTypeRef fnsig = LLVMGetElementType(LLVMTypeOf(mainfn));
+    genlJitMainInt = LLVMGetTypeKind(LLVMGetReturnType(fnsig)) == LLVMIntegerTypeKind;
+
+    // The JIT takes ownership of a machine of its own
+    LLVMTargetMachineRef machine = genlCreateMachine(gen->opt);
+    if (!machine) {
+        LLVMDisposeModule(gen->module);
+        return;
+    }
+    if (!genlJitLoad(gen->module, machine))
+        genlJitMain = NULL;
+}
+
+// Run the program prepared by genlJit, returning main's result as the exit code
+int genRun(GenState *gen) {
+    int result = 0;
+    if (!genlJitMain)
+        return ExitError;
+    if (genlJitMainInt)
+        result = ((int (*)())genlJitMain)();
+    else
+        ((void (*)())genlJitMain)();
+    genlJitDispose();
+    return result;
+}
@@ -17,9 +17,12 @@
 #include <llvm-c/ExecutionEngine.h>
 #include <llvm-c/Target.h>
 #include <llvm-c/Analysis.h>
+#include <llvm-c/Support.h>
 #include <llvm-c/BitWriter.h>
 #include <llvm-c/Transforms/Scalar.h>
 #include <llvm-c/Transforms/IPO.h>
+#include <llvm-c/Transforms/Vectorize.h>
+#include <llvm-c/Transforms/PassManagerBuilder.h>
 #if LLVM_VERSION_MAJOR >= 7
 #include "llvm-c/Transforms/Utils.h"
 #endif
@@ -42,20 +45,34 @@ void genlParmVar(GenState *gen, VarDclNode *var) {
     // We always alloca in case variable is mutable or we want to take address of its value
     var->llvmvar = genlAlloca(gen, genlType(gen, var->vtype), &var->namesym->namestr);
     LLVMBuildStore(gen->builder, LLVMGetParam(gen->fn, var->index), var->llvmvar);
+    genlDropFlagDcl(gen, var, 1);
 }
 
 // Generate a function
 void genlFn(GenState *gen, FnDclNode *fnnode) {
     if (fnnode->value->tag == IntrinsicTag)
         return;
+    if (fnnode->versions)
+        genlMultiVerFn(gen, fnnode);
+    else
+        genlFnBody(gen, fnnode, fnnode->llvmvar);
+}
 
+// Generate a function's code into fn
+void genlFnBody(GenState *gen, FnDclNode *fnnode, LLVMValueRef fn) {
     LLVMValueRef svfn = gen->fn;
     LLVMBuilderRef svbuilder = gen->builder;
     LLVMValueRef svallocaPoint = gen->allocaPoint;
+    LLVMBasicBlockRef svpanicblk = gen->panicblk;
+
+    // Work arrays used while generating the function's code are temporary
+    MemTmpMark tmpmark = memTmpMark();
 
     FnSigNode *fnsig = (FnSigNode*)fnnode->vtype;
     assert(fnnode->value->tag == BlockTag);
-    gen->fn = fnnode->llvmvar;
+    gen->fn = fn;
+    gen->panicblk = NULL;
+    gen->dbgfn = NULL;
 
     // Attach block and builder to function
     LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(gen->context, gen->fn, "entry");
@@ -81,10 +98,13 @@ void genlFn(GenState *gen, FnDclNode *fnnode) {
         LLVMInstructionEraseFromParent(allocaPoint);
 
     LLVMDisposeBuilder(gen->builder);
+    memTmpRelease(tmpmark);
 
     gen->builder = svbuilder;
     gen->fn = svfn;
     gen->allocaPoint = svallocaPoint;
+    gen->panicblk = svpanicblk;
+    gen->dbgfn = NULL;
 }
 
 // Insert every alloca before the allocaPoint in the function's entry block.
@@ -92,9 +112,16 @@ void genlFn(GenState *gen, FnDclNode *fnnode) {
 // should be located in the function's entry block before the first call.
 LLVMValueRef genlAlloca(GenState *gen, LLVMTypeRef type, const char *name) {
     LLVMBasicBlockRef current_block = LLVMGetInsertBlock(gen->builder);
+    // Positioning the builder takes on the allocaPoint's (missing) debug location
+#if LLVM_VERSION_MAJOR >= 9
+    LLVMMetadataRef debugloc = LLVMGetCurrentDebugLocation2(gen->builder);
+#endif
     LLVMPositionBuilderBefore(gen->builder, gen->allocaPoint);
     LLVMValueRef alloca = LLVMBuildAlloca(gen->builder, type, name);
     LLVMPositionBuilderAtEnd(gen->builder, current_block);
+#if LLVM_VERSION_MAJOR >= 9
+    LLVMSetCurrentDebugLocation2(gen->builder, debugloc);
+#endif
     return alloca;
 }
 
@@ -162,17 +189,26 @@ void genlGloFnName(GenState *gen, FnDclNode *glofn) {
         }
 
         // Add metadata on implemented functions (debug mode only)
-        if (!gen->opt->release && glofn->value) {
-            LLVMMetadataRef fntype = LLVMDIBuilderCreateSubroutineType(gen->dibuilder,
-                gen->difile, NULL, 0, 0);
-            LLVMMetadataRef sp = LLVMDIBuilderCreateFunction(gen->dibuilder, gen->difile,
-                fnname, strlen(fnname), manglednm, strlen(manglednm),
-                gen->difile, glofn->linenbr, fntype, 0, 1, glofn->linenbr, LLVMDIFlagPublic, 0);
-            LLVMSetSubprogram(glofn->llvmvar, sp);
-        }
+        if (!gen->opt->release && glofn->value)
+            genlFnDebugInfo(gen, glofn, glofn->llvmvar, manglednm);
+        if (glofn->versions && glofn->value && glofn->value->tag == BlockTag)
+            genlMultiVerName(gen, glofn, manglednm);
     }
 }
 
+// Attach debug info for a function declaration to fn, generated for it
+void genlFnDebugInfo(GenState *gen, FnDclNode *glofn, LLVMValueRef fn, char *manglednm) {
+    char *fnname = glofn->namesym? &glofn->namesym->namestr : "";
+    SrcPos pos;
+    lexSrcPos(glofn->srcloc, &pos);
+    LLVMMetadataRef fntype = LLVMDIBuilderCreateSubroutineType(gen->dibuilder,
+        gen->difile, NULL, 0, 0);
+    LLVMMetadataRef sp = LLVMDIBuilderCreateFunction(gen->dibuilder, gen->difile,
+        fnname, strlen(fnname), manglednm, strlen(manglednm),
+        gen->difile, pos.linenbr, fntype, 0, 1, pos.linenbr, LLVMDIFlagPublic, 0);
+    LLVMSetSubprogram(fn, sp);
+}
+
 // Generate all instantiations of generic functions
 void genlGeneric(GenState *gen, GenericNode *gennode, int dobody) {
     if (gennode->body->tag != FnDclTag)
@@ -248,16 +284,125 @@ void genlModule(GenState *gen, ModuleNode *mod) {
 void genlPackage(GenState *gen, ModuleNode *mod) {
 
     assert(mod->tag == ModuleTag);
+    MemTmpMark tmpmark = memTmpMark();  // e.g., for global variables' literal values
     gen->module = LLVMModuleCreateWithNameInContext(gen->opt->srcname, gen->context);
     if (!gen->opt->release) {
         gen->dibuilder = LLVMCreateDIBuilder(gen->module);
         gen->difile = LLVMDIBuilderCreateFile(gen->dibuilder, "main.cone", 9, ".", 1);
         gen->compileUnit = LLVMDIBuilderCreateCompileUnit(gen->dibuilder, LLVMDWARFSourceLanguageC,
             gen->difile, "Cone compiler", 13, 0, "", 0, 0, "", 0, LLVMDWARFEmissionFull, 0, 0, 0);
+        // Without this, debug info is stripped whenever the module is loaded from bitcode
+        // (as when emitting asm and partitions on other threads)
+        LLVMAddModuleFlag(gen->module, LLVMModuleFlagBehaviorWarning, "Debug Info Version", 18,
+            LLVMValueAsMetadata(LLVMConstInt(LLVMInt32TypeInContext(gen->context), LLVMDebugMetadataVersion(), 0)));
     }
     genlModule(gen, mod);
     if (!gen->opt->release)
         LLVMDIBuilderFinalize(gen->dibuilder);
+    memTmpRelease(tmpmark);
+}
+
+// The LLVM backends conec can initialize: all those LLVM was built with or, when
+// built with CMake's CONE_TARGETS, only those chosen there (and linked in)
+typedef struct {
+    char *name;
+    void (*init)(void);
+} GenTargetInit;
+
+static GenTargetInit genlTargetInfos[] = {
+#define LLVM_TARGET(name) {#name, LLVMInitialize##name##TargetInfo},
+#ifdef CONE_TARGETS_SUBSET
+#include "conetargets/Targets.def"
+#else
+#include "llvm/Config/Targets.def"
+#endif
+    {NULL, NULL}
+};
+static GenTargetInit genlTargets[] = {
+#define LLVM_TARGET(name) {#name, LLVMInitialize##name##Target},
+#ifdef CONE_TARGETS_SUBSET
+#include "conetargets/Targets.def"
+#else
+#include "llvm/Config/Targets.def"
+#endif
+    {NULL, NULL}
+};
+static GenTargetInit genlTargetMCs[] = {
+#define LLVM_TARGET(name) {#name, LLVMInitialize##name##TargetMC},
+#ifdef CONE_TARGETS_SUBSET
+#include "conetargets/Targets.def"
+#else
+#include "llvm/Config/Targets.def"
+#endif
+    {NULL, NULL}
+};
+static GenTargetInit genlAsmPrinters[] = {
+#define LLVM_ASM_PRINTER(name) {#name, LLVMInitialize##name##AsmPrinter},
+#ifdef CONE_TARGETS_SUBSET
+#include "conetargets/AsmPrinters.def"
+#else
+#include "llvm/Config/AsmPrinters.def"
+#endif
+    {NULL, NULL}
+};
+static GenTargetInit genlAsmParsers[] = {
+#define LLVM_ASM_PARSER(name) {#name, LLVMInitialize##name##AsmParser},
+#ifdef CONE_TARGETS_SUBSET
+#include "conetargets/AsmParsers.def"
+#else
+#include "llvm/Config/AsmParsers.def"
+#endif
+    {NULL, NULL}
+};
+
+// The LLVM backend for each architecture, by the prefix of its triple.
+// Longer prefixes come before the shorter ones they start with.
+static char *genlTargetArchs[][2] = {
+    {"x86_64", "X86"}, {"amd64", "X86"}, {"i386", "X86"}, {"i486", "X86"}, {"i586", "X86"}, {"i686", "X86"},
+    {"aarch64", "AArch64"}, {"arm64", "AArch64"}, {"arm", "ARM"}, {"thumb", "ARM"},
+    {"wasm", "WebAssembly"}, {"riscv", "RISCV"}, {"mips", "Mips"},
+    {"powerpc", "PowerPC"}, {"ppc", "PowerPC"}, {"sparc", "Sparc"},
+    {"s390x", "SystemZ"}, {"systemz", "SystemZ"}, {"amdgcn", "AMDGPU"}, {"r600", "AMDGPU"},
+    {"nvptx", "NVPTX"}, {"avr", "AVR"}, {"bpf", "BPF"}, {"hexagon", "Hexagon"},
+    {"lanai", "Lanai"}, {"msp430", "MSP430"}, {"xcore", "XCore"}, {"m68k", "M68k"}, {"ve", "VE"},
+};
+
+// Run a backend's initializer from the table, if it has one there. Return 1 if found.
+static int genlInitFrom(GenTargetInit *inits, char *name) {
+    for (; inits->name; ++inits) {
+        if (strcmp(inits->name, name) == 0) {
+            inits->init();
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Initialize the LLVM backend for the triple's architecture. Only if the
+// architecture is not known here are all backends initialized, to let LLVM sort it out.
+static void genlInitTarget(char *triple) {
+    size_t i;
+    for (i = 0; i < sizeof(genlTargetArchs) / sizeof(genlTargetArchs[0]); ++i) {
+        char *name = genlTargetArchs[i][1];
+        if (strncmp(triple, genlTargetArchs[i][0], strlen(genlTargetArchs[i][0])) != 0)
+            continue;
+        if (genlInitFrom(genlTargetInfos, name)) {
+            genlInitFrom(genlTargets, name);
+            genlInitFrom(genlTargetMCs, name);
+            genlInitFrom(genlAsmPrinters, name);
+            genlInitFrom(genlAsmParsers, name);
+        }
+        return;    // If not built in, LLVMGetTargetFromTriple reports it
+    }
+    for (i = 0; genlTargetInfos[i].name; ++i) {
+        genlTargetInfos[i].init();
+        genlTargets[i].init();
+        genlTargetMCs[i].init();
+    }
+    for (i = 0; genlAsmPrinters[i].name; ++i)
+        genlAsmPrinters[i].init();
+    for (i = 0; genlAsmParsers[i].name; ++i)
+        genlAsmParsers[i].init();
 }
 
 // Use provided options (triple, etc.) to creation a machine
@@ -268,15 +413,10 @@ LLVMTargetMachineRef genlCreateMachine(ConeOptions *opt) {
     LLVMRelocMode reloc;
     LLVMTargetMachineRef machine;
 
-    LLVMInitializeAllTargetInfos();
-    LLVMInitializeAllTargetMCs();
-    LLVMInitializeAllTargets();
-    LLVMInitializeAllAsmPrinters();
-    LLVMInitializeAllAsmParsers();
-
-    // Find target for the specified triple
+    // Find target for the specified triple, initializing only its backend
     if (!opt->triple)
         opt->triple = LLVMGetDefaultTargetTriple();
+    genlInitTarget(opt->triple);
     if (LLVMGetTargetFromTriple(opt->triple, &target, &err) != 0) {
         errorMsg(ErrorGenErr, "Could not create target: %s", err);
         LLVMDisposeMessage(err);
@@ -284,10 +424,27 @@ LLVMTargetMachineRef genlCreateMachine(ConeOptions *opt) {
     }
 
     // Create a specific target machine
-    opt_level = opt->release? LLVMCodeGenLevelAggressive : LLVMCodeGenLevelNone;
-    reloc = (opt->pic || opt->library)? LLVMRelocPIC : LLVMRelocDefault;
+    switch (opt->optlevel) {
+    case 0: opt_level = LLVMCodeGenLevelNone; break;    // LLVM then selects with FastISel
+    case 1: opt_level = LLVMCodeGenLevelLess; break;
+    case 2: opt_level = LLVMCodeGenLevelDefault; break;
+    default: opt_level = LLVMCodeGenLevelAggressive; break;
+    }
+    // Code run by the JIT may land far from the data and functions it refers to
+    reloc = (opt->pic || opt->library || opt->run)? LLVMRelocPIC : LLVMRelocDefault;
     if (!opt->cpu)
         opt->cpu = "generic";
+    else if (strcmp(opt->cpu, "native") == 0) {
+        // Resolve to the host's CPU and features now, so the cache key names them
+        char *name = LLVMGetHostCPUName();
+        opt->cpu = memAllocStr(name, strlen(name));
+        LLVMDisposeMessage(name);
+        if (!opt->features) {
+            char *features = LLVMGetHostCPUFeatures();
+            opt->features = memAllocStr(features, strlen(features));
+            LLVMDisposeMessage(features);
+        }
+    }
     if (!opt->features)
         opt->features = "";
     if (!(machine = LLVMCreateTargetMachine(target, opt->triple, opt->cpu, opt->features, opt_level, reloc, LLVMCodeModelDefault))) {
@@ -298,9 +455,8 @@ LLVMTargetMachineRef genlCreateMachine(ConeOptions *opt) {
     return machine;
 }
 
-// Generate requested object file
-void genlOut(char *objpath, char *asmpath, LLVMModuleRef mod, char *triple, LLVMTargetMachineRef machine) {
-    char *err;
+// Give the module its target triple and data layout, so optimizations can make use of them
+void genlTarget(LLVMModuleRef mod, char *triple, LLVMTargetMachineRef machine) {
     LLVMTargetDataRef dataref;
     char *layout;
 
@@ -309,23 +465,70 @@ void genlOut(char *objpath, char *asmpath, LLVMModuleRef mod, char *triple, LLVM
     layout = LLVMCopyStringRepOfTargetData(dataref);
     LLVMSetDataLayout(mod, layout);
     LLVMDisposeMessage(layout);
+    LLVMDisposeTargetData(dataref);
+}
 
-    // Generate assembly file if requested
-    if (asmpath && LLVMTargetMachineEmitToFile(machine, mod, asmpath, LLVMAssemblyFile, &err) != 0) {
-        errorMsg(ErrorGenErr, "Could not emit asm file: %s", err);
-        LLVMDisposeMessage(err);
+// Generate requested object file
+// Optimize the module's LLVM IR using the standard pipelines for the chosen
+// optimization level (-O0 to -O3) and size level (-Os, -Oz).
+// The machine, when given, tells the optimizer about the target's costs (e.g., vector width).
+void genlOptimize(LLVMModuleRef mod, ConeOptions *opt, LLVMTargetMachineRef machine) {
+    LLVMValueRef fn;
+
+    // Debug builds only promote locals to registers. Local variables' allocas are
+    // all placed in the entry block, so this is enough to give instruction selection SSA values.
+    if (opt->optlevel == 0) {
+        LLVMPassManagerRef fnpasses = LLVMCreateFunctionPassManagerForModule(mod);
+        LLVMAddPromoteMemoryToRegisterPass(fnpasses);
+        LLVMInitializeFunctionPassManager(fnpasses);
+        for (fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn))
+            LLVMRunFunctionPassManager(fnpasses, fn);
+        LLVMFinalizeFunctionPassManager(fnpasses);
+        LLVMDisposePassManager(fnpasses);
+        return;
     }
 
-    // Generate .o or .obj file
-    if (LLVMTargetMachineEmitToFile(machine, mod, objpath, LLVMObjectFile, &err) != 0) {
-        errorMsg(ErrorGenErr, "Could not emit obj file: %s", err);
-        LLVMDisposeMessage(err);
+    LLVMPassManagerBuilderRef pmb = LLVMPassManagerBuilderCreate();
+    LLVMPassManagerBuilderSetOptLevel(pmb, opt->optlevel);
+    LLVMPassManagerBuilderSetSizeLevel(pmb, opt->sizelevel);
+    if (opt->optlevel > 1) {
+        // Same inlining thresholds as clang
+        unsigned threshold = opt->sizelevel == 2 ? 25 : opt->sizelevel == 1 ? 75 : opt->optlevel > 2 ? 250 : 225;
+        LLVMPassManagerBuilderUseInlinerWithThreshold(pmb, threshold);
     }
+
+    // Per-function simplification, run over each function first
+    LLVMPassManagerRef fnpasses = LLVMCreateFunctionPassManagerForModule(mod);
+    if (machine)
+        LLVMAddAnalysisPasses(machine, fnpasses);
+    LLVMPassManagerBuilderPopulateFunctionPassManager(pmb, fnpasses);
+    LLVMInitializeFunctionPassManager(fnpasses);
+    for (fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn))
+        LLVMRunFunctionPassManager(fnpasses, fn);
+    LLVMFinalizeFunctionPassManager(fnpasses);
+    LLVMDisposePassManager(fnpasses);
+
+    // Whole-module pipeline: inlining, IPO, loop optimizations and dead global elimination
+    LLVMPassManagerRef modpasses = LLVMCreatePassManager();
+    if (machine)
+        LLVMAddAnalysisPasses(machine, modpasses);
+    LLVMPassManagerBuilderPopulateModulePassManager(pmb, modpasses);
+    // The C API builder leaves the vectorizers off; enable them as clang does, then clean up after them
+    if (opt->optlevel > 1 && opt->sizelevel < 2) {
+        LLVMAddLoopVectorizePass(modpasses);
+        LLVMAddSLPVectorizePass(modpasses);
+        LLVMAddInstructionCombiningPass(modpasses);
+        LLVMAddCFGSimplificationPass(modpasses);
+    }
+    LLVMRunPassManager(modpasses, mod);
+    LLVMDisposePassManager(modpasses);
+    LLVMPassManagerBuilderDispose(pmb);
 }
 
 // Generate IR nodes into LLVM IR using LLVM
 void genmod(GenState *gen, ModuleNode *mod) {
     char *err;
+    char *fname = lexSrcFile(mod->srcloc)->fname;
 
     // Generate IR to LLVM IR
     genlPackage(gen, mod);
@@ -343,36 +546,65 @@ void genmod(GenState *gen, ModuleNode *mod) {
     }
 
     // Serialize the LLVM IR, if requested
-    if (gen->opt->print_llvmir && LLVMPrintModuleToFile(gen->module, fileMakePath(gen->opt->output, mod->lexer->fname, "preir"), &err) != 0) {
+    if (gen->opt->print_llvmir && LLVMPrintModuleToFile(gen->module, fileMakePath(gen->opt->output, fname, "preir"), &err) != 0) {
         errorMsg(ErrorGenErr, "Could not emit pre-ir file: %s", err);
         LLVMDisposeMessage(err);
     }
 
+    // Reuse the objects already generated for identical IR, if cached
+    char *objpath = NULL, *asmpath = NULL, *cachekey = NULL;
+    char *fobjext = gen->opt->wasm? "wasm" : objext;
+    char *fasmext = gen->opt->wasm? "wat" : asmext;
+    if (gen->machine && !gen->opt->run) {
+        objpath = fileMakePath(gen->opt->output, fname, fobjext);
+        asmpath = gen->opt->print_asm? fileMakePath(gen->opt->output, fname, fasmext) : NULL;
+    }
+    if (gen->opt->incremental && objpath && !gen->opt->print_llvmir) {
+        timerBegin(OptTimer);
+        genlIncremental(gen, fname, fobjext, fasmext);
+        timerBegin(CodeGenTimer);
+        return;
+    }
+    if (gen->opt->cache && objpath && gen->opt->jobs <= 1 && !gen->opt->print_llvmir) {
+        cachekey = genlCacheKey(gen);
+        if (genlCacheGet(gen->opt, cachekey, objpath, fobjext, asmpath, fasmext)) {
+            LLVMDisposeModule(gen->module);
+            return;
+        }
+    }
+
     // Optimize the generated LLVM IR
     timerBegin(OptTimer);
-    LLVMPassManagerRef passmgr = LLVMCreatePassManager();
-    LLVMAddPromoteMemoryToRegisterPass(passmgr);     // Demote allocas to registers.
-    LLVMAddInstructionCombiningPass(passmgr);        // Do simple "peephole" and bit-twiddling optimizations
-    LLVMAddReassociatePass(passmgr);                 // Reassociate expressions.
-    LLVMAddGVNPass(passmgr);                         // Eliminate common subexpressions.
-    LLVMAddCFGSimplificationPass(passmgr);           // Simplify the control flow graph
-    if (gen->opt->release)
-        LLVMAddFunctionInliningPass(passmgr);        // Function inlining
-    LLVMRunPassManager(passmgr, gen->module);
-    LLVMDisposePassManager(passmgr);
+
+    // With several jobs, partitions are optimized and emitted concurrently.
+    // That all counts as optimization time, as the two stages overlap across workers.
+    if (gen->opt->jobs > 1 && !gen->opt->run) {
+        genlParallel(gen, fname, fobjext, fasmext);
+        timerBegin(CodeGenTimer);
+        return;
+    }
+
+    if (gen->machine)
+        genlTarget(gen->module, gen->opt->triple, gen->machine);
+    genlOptimize(gen->module, gen->opt, gen->machine);
 
     // Serialize the LLVM IR, if requested
-    if (gen->opt->print_llvmir && LLVMPrintModuleToFile(gen->module, fileMakePath(gen->opt->output, mod->lexer->fname, "ir"), &err) != 0) {
+    if (gen->opt->print_llvmir && LLVMPrintModuleToFile(gen->module, fileMakePath(gen->opt->output, fname, "ir"), &err) != 0) {
         errorMsg(ErrorGenErr, "Could not emit ir file: %s", err);
         LLVMDisposeMessage(err);
     }
 
-    // Transform IR to target's ASM and OBJ
+    // Transform IR to target's ASM and OBJ, or into memory to be run
     timerBegin(CodeGenTimer);
-    if (gen->machine)
-        genlOut(fileMakePath(gen->opt->output, mod->lexer->fname, gen->opt->wasm? "wasm" : objext),
-            gen->opt->print_asm? fileMakePath(gen->opt->output, mod->lexer->fname, gen->opt->wasm? "wat" : asmext) : NULL,
-            gen->module, gen->opt->triple, gen->machine);
+    if (gen->opt->run) {
+        genlJit(gen);
+        return;
+    }
+    if (gen->machine) {
+        genlOut(gen, objpath, asmpath);
+        if (cachekey && errors == 0)
+            genlCachePut(gen->opt, cachekey, objpath, fobjext, asmpath, fasmext);
+    }
 
     LLVMDisposeModule(gen->module);
     // LLVMContextDispose(gen.context);  // Only need if we created a new context
@@ -397,6 +629,22 @@ void genSetup(GenState *gen, ConeOptions *opt) {
     gen->block = NULL;
     gen->loopstack = memAllocBlk(sizeof(GenLoopState)*GenLoopMax);
     gen->loopstackcnt = 0;
+    gen->panicblk = NULL;
+    gen->dbgfn = NULL;
+    gen->dbglinesrcloc = gen->dbglineend = 0;
+}
+
+// Set up LLVM's targets ahead of any compile (for a compile server), and
+// return the target's pointer size in bits, for parsing the core library, or 0
+int genPrepare(ConeOptions *opt) {
+    LLVMTargetMachineRef machine = genlCreateMachine(opt);
+    if (!machine)
+        return 0;
+    LLVMTargetDataRef datalayout = LLVMCreateTargetDataLayout(machine);
+    int ptrsize = LLVMPointerSize(datalayout) << 3;
+    LLVMDisposeTargetData(datalayout);
+    LLVMDisposeTargetMachine(machine);
+    return ptrsize;
 }
 
 void genClose(GenState *gen) {
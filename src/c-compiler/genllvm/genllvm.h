@@ -43,15 +43,62 @@ typedef struct GenState {
     ConeOptions *opt;
     GenLoopState *loopstack;
     uint32_t loopstackcnt;
+    LLVMBasicBlockRef panicblk;  // The function's shared bounds check failure block (or NULL)
+
+    // Where the builder's debug location was last set (non-release builds)
+    LLVMValueRef dbgfn;          // Function it was set in (NULL if not yet set in this one)
+    uint32_t dbgsrcloc;          // Source location it was set to
+    uint32_t dbglinesrcloc;      // Source locations of the line it is on, up to dbglineend
+    uint32_t dbglineend;
+    uint32_t dbglinenbr;         // That line's number
 } GenState;
 
 // Setup LLVM generation, ensuring we know intended target
 void genSetup(GenState *gen, ConeOptions *opt);
+// Set up LLVM's targets ahead of compiles, returning the pointer size in bits
+int genPrepare(ConeOptions *opt);
 void genClose(GenState *gen);
 void genmod(GenState *gen, ModuleNode *mod);
+// Run the program generated by genmod with --run, returning its exit code
+int genRun(GenState *gen);
 void genlFn(GenState *gen, FnDclNode *fnnode);
+// Generate a function's code into fn
+void genlFnBody(GenState *gen, FnDclNode *fnnode, LLVMValueRef fn);
 void genlGloVarName(GenState *gen, VarDclNode *glovar);
 void genlGloFnName(GenState *gen, FnDclNode *glofn);
+// Attach debug info for a function declaration to fn, generated for it
+void genlFnDebugInfo(GenState *gen, FnDclNode *glofn, LLVMValueRef fn, char *manglednm);
+LLVMTargetMachineRef genlCreateMachine(ConeOptions *opt);
+void genlTarget(LLVMModuleRef mod, char *triple, LLVMTargetMachineRef machine);
+void genlOptimize(LLVMModuleRef mod, ConeOptions *opt, LLVMTargetMachineRef machine);
+
+// genlcache.c
+// Make an object cache key from a hash and length of content, and the target settings
+char *genlCacheKeyOf(ConeOptions *opt, uint64_t hash, size_t len);
+// Make the object cache key for the generated module
+char *genlCacheKey(GenState *gen);
+// Copy a module's cached outputs to their paths, returning 0 if not cached
+int genlCacheGet(ConeOptions *opt, char *key, char *objpath, char *objext, char *asmpath, char *asmext);
+// Add a module's freshly generated outputs to the cache
+void genlCachePut(ConeOptions *opt, char *key, char *objpath, char *objext, char *asmpath, char *asmext);
+
+// genljit.c
+// Prepare the generated module to be run in-process by genRun
+void genlJit(GenState *gen);
+
+// genlmultiver.c
+// Declare the clones of a multiversioned function, and the pointer its thunk calls through
+void genlMultiVerName(GenState *gen, FnDclNode *glofn, char *manglednm);
+// Generate the clones' bodies, the resolver that picks one, and the thunk that calls it
+void genlMultiVerFn(GenState *gen, FnDclNode *fnnode);
+
+// genlpart.c
+// Emit the optimized module's object file and, when asmpath is given, its assembly at the same time
+void genlOut(GenState *gen, char *objpath, char *asmpath);
+// Optimize and emit the generated module as partitions on several threads
+void genlParallel(GenState *gen, char *fname, char *objext, char *asmext);
+// Emit the generated module as units, recompiling only those not in the object cache
+void genlIncremental(GenState *gen, char *fname, char *objext, char *asmext);
 
 // genlstmt.c
 LLVMBasicBlockRef genlInsertBlock(GenState *gen, char *name);
@@ -60,6 +107,8 @@ LLVMValueRef genlLoop(GenState *gen, LoopNode *wnode);
 
 // genlexpr.c
 LLVMValueRef genlExpr(GenState *gen, INode *termnode);
+// Mark a conditional branch as almost always taking its first (true) path
+void genlBranchLikely(GenState *gen, LLVMValueRef condbr);
 
 // genlalloc.c
 // Generate code that creates an allocated ref by allocating and initializing
@@ -70,6 +119,10 @@ void genlDealiasNodes(GenState *gen, Nodes *nodes);
 void genlRcCounter(GenState *gen, LLVMValueRef ref, long long amount, RefNode *refnode);
 // Dealias an own allocated reference
 void genlDealiasOwn(GenState *gen, LLVMValueRef ref, RefNode *refnode);
+// Declare a VarDropFlag variable's flag, as it is declared (no-op for other variables)
+void genlDropFlagDcl(GenState *gen, VarDclNode *var, int live);
+// Record whether a VarDropFlag variable has a value to drop (no-op for other variables)
+void genlDropFlag(GenState *gen, VarDclNode *var, int live);
 // Create an alloca (will be pushed to the entry point of the function.
 LLVMValueRef genlAlloca(GenState *gen, LLVMTypeRef type, const char *name);
 
@@ -0,0 +1,227 @@
+/** Function multiversioning: clones for several x86 feature levels, one chosen at run time
+ * @file
+ *
+ * A function marked multiversion is generated once for the target as given
+ * (its ".default" clone) and again for each feature level it names, with those
+ * features enabled. The function's own symbol becomes a thunk that calls through
+ * a pointer. The pointer starts out at a resolver that, on the first call, checks
+ * the running CPU (with cpuid and xgetbv, so nothing from a runtime library is
+ * needed), keeps the best clone the CPU and OS can run, and calls that instead.
+ *
+ * Only x86-64 targets are multiversioned. Elsewhere, just the target's own
+ * version is generated.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../shared/error.h"
+#include "../shared/memory.h"
+#include "../coneopts.h"
+#include "genllvm.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// A feature level a function may be multiversioned for, in increasing order of preference
+typedef struct {
+    char *name;         // As named after multiversion
+    char *features;     // LLVM target features enabled for its clone
+    uint32_t ecx1;      // Bits needed in ecx of cpuid leaf 1
+    uint32_t ebx7;      // Bits needed in ebx of cpuid leaf 7
+    uint32_t xcr0;      // Register state the OS must save (xgetbv), for AVX's wider registers
+} GenMultiLevel;
+
+#define CpuidSse42   (1u << 20)
+#define CpuidPopcnt  (1u << 23)
+#define CpuidOsxsave (1u << 27)
+#define CpuidAvx     (1u << 28)
+#define CpuidAvx2    (1u << 5)
+#define CpuidAvx512f (1u << 16)
+#define XcrAvx       0x06u      // SSE and AVX state
+#define XcrAvx512    0xe6u      // ... and opmask and upper ZMM state
+
+static GenMultiLevel genlMultiLevels[] = {
+    { "sse4.2", "+sse4.2,+popcnt", CpuidSse42 | CpuidPopcnt, 0, 0 },
+    { "avx", "+avx", CpuidOsxsave | CpuidAvx, 0, XcrAvx },
+    { "avx2", "+avx2", CpuidOsxsave | CpuidAvx, CpuidAvx2, XcrAvx },
+    { "avx512f", "+avx512f", CpuidOsxsave | CpuidAvx, CpuidAvx2 | CpuidAvx512f, XcrAvx512 },
+};
+#define GenMultiLevelCnt (sizeof(genlMultiLevels) / sizeof(GenMultiLevel))
+
+// Is level named in the comma-separated list of versions?
+static int genlMultiNamed(char *versions, char *level) {
+    size_t len = strlen(level);
+    char *namep = versions;
+    while (namep && *namep) {
+        char *endp = strchr(namep, ',');
+        size_t namelen = endp? (size_t)(endp - namep) : strlen(namep);
+        if (namelen == len && strncmp(namep, level, len) == 0)
+            return 1;
+        namep = endp? endp + 1 : NULL;
+    }
+    return 0;
+}
+
+// Name a clone or helper of the multiversioned function: <fnname>.<suffix>
+static char *genlMultiName(char *buf, size_t size, LLVMValueRef fn, char *suffix) {
+    snprintf(buf, size, "%s.%s", LLVMGetValueName(fn), suffix);
+    return buf;
+}
+
+// Declare the clones of a multiversioned function, and the pointer its thunk calls through
+void genlMultiVerName(GenState *gen, FnDclNode *glofn, char *manglednm) {
+    char namebuf[2200];
+    size_t i;
+
+    // Every level named must be known, for the error to be the same on any target
+    char *namep = glofn->versions;
+    while (namep && *namep) {
+        char *endp = strchr(namep, ',');
+        size_t namelen = endp? (size_t)(endp - namep) : strlen(namep);
+        for (i = 0; i < GenMultiLevelCnt; ++i)
+            if (strlen(genlMultiLevels[i].name) == namelen && strncmp(namep, genlMultiLevels[i].name, namelen) == 0)
+                break;
+        if (i == GenMultiLevelCnt)
+            errorMsgNode((INode*)glofn, ErrorGenErr, "Unknown multiversion feature level \"%.*s\"", (int)namelen, namep);
+        namep = endp? endp + 1 : NULL;
+    }
+    if (strncmp(gen->opt->triple, "x86_64", 6) != 0 && strncmp(gen->opt->triple, "amd64", 5) != 0)
+        return;
+
+    LLVMTypeRef fntype = genlType(gen, glofn->vtype);
+    LLVMValueRef clone = LLVMAddFunction(gen->module, genlMultiName(namebuf, sizeof(namebuf), glofn->llvmvar, "default"), fntype);
+    LLVMSetVisibility(clone, LLVMHiddenVisibility);
+    if (!gen->opt->release)
+        genlFnDebugInfo(gen, glofn, clone, manglednm);
+    for (i = 0; i < GenMultiLevelCnt; ++i) {
+        GenMultiLevel *level = &genlMultiLevels[i];
+        if (!genlMultiNamed(glofn->versions, level->name))
+            continue;
+        clone = LLVMAddFunction(gen->module, genlMultiName(namebuf, sizeof(namebuf), glofn->llvmvar, level->name), fntype);
+        LLVMSetVisibility(clone, LLVMHiddenVisibility);
+        // A function's target features replace the target machine's, so both are given
+        char *features = gen->opt->features;
+        snprintf(namebuf, sizeof(namebuf), "%s%s%s", features, *features? "," : "", level->features);
+        LLVMAddTargetDependentFunctionAttr(clone, "target-features", namebuf);
+        if (!gen->opt->release)
+            genlFnDebugInfo(gen, glofn, clone, manglednm);
+    }
+
+    LLVMValueRef resolve = LLVMAddFunction(gen->module, genlMultiName(namebuf, sizeof(namebuf), glofn->llvmvar, "resolve"), fntype);
+    LLVMSetVisibility(resolve, LLVMHiddenVisibility);
+    LLVMValueRef fnptr = LLVMAddGlobal(gen->module, LLVMPointerType(fntype, 0), genlMultiName(namebuf, sizeof(namebuf), glofn->llvmvar, "ptr"));
+    LLVMSetVisibility(fnptr, LLVMHiddenVisibility);
+    LLVMSetInitializer(fnptr, resolve);
+}
+
+// Call fn with the parameters of the function being generated, and return what it does
+static void genlMultiTailCall(GenState *gen, LLVMValueRef fn) {
+    unsigned i, cnt = LLVMCountParams(gen->fn);
+    LLVMValueRef *args = (LLVMValueRef*)memAllocTmp(cnt * sizeof(LLVMValueRef));
+    for (i = 0; i < cnt; ++i)
+        args[i] = LLVMGetParam(gen->fn, i);
+    LLVMValueRef ret = LLVMBuildCall(gen->builder, fn, args, cnt, "");
+    LLVMSetTailCall(ret, 1);
+    if (LLVMGetTypeKind(LLVMTypeOf(ret)) == LLVMVoidTypeKind)
+        LLVMBuildRetVoid(gen->builder);
+    else
+        LLVMBuildRet(gen->builder, ret);
+}
+
+// Generate a call to cpuid for a leaf (and subleaf 0), returning {eax, ebx, ecx, edx}
+static LLVMValueRef genlMultiCpuid(GenState *gen, unsigned leaf) {
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(gen->context);
+    LLVMTypeRef regs[4] = { i32, i32, i32, i32 };
+    LLVMTypeRef parms[2] = { i32, i32 };
+    LLVMTypeRef asmtype = LLVMFunctionType(LLVMStructTypeInContext(gen->context, regs, 4, 0), parms, 2, 0);
+    LLVMValueRef cpuid = LLVMConstInlineAsm(asmtype, "cpuid", "={ax},={bx},={cx},={dx},0,2", 0, 0);
+    LLVMValueRef args[2] = { LLVMConstInt(i32, leaf, 0), LLVMConstInt(i32, 0, 0) };
+    return LLVMBuildCall(gen->builder, cpuid, args, 2, "");
+}
+
+// Generate (reg & bits) == bits
+static LLVMValueRef genlMultiHas(GenState *gen, LLVMValueRef reg, uint32_t bits) {
+    LLVMValueRef mask = LLVMConstInt(LLVMInt32TypeInContext(gen->context), bits, 0);
+    return LLVMBuildICmp(gen->builder, LLVMIntEQ, LLVMBuildAnd(gen->builder, reg, mask, ""), mask, "");
+}
+
+// Generate the clones' bodies, the resolver that picks one, and the thunk that calls it
+void genlMultiVerFn(GenState *gen, FnDclNode *fnnode) {
+    char namebuf[2200];
+    LLVMValueRef fnptr = LLVMGetNamedGlobal(gen->module, genlMultiName(namebuf, sizeof(namebuf), fnnode->llvmvar, "ptr"));
+    if (!fnptr) {
+        genlFnBody(gen, fnnode, fnnode->llvmvar);
+        return;
+    }
+    LLVMValueRef clones[GenMultiLevelCnt + 1];
+    size_t i;
+    clones[0] = LLVMGetNamedFunction(gen->module, genlMultiName(namebuf, sizeof(namebuf), fnnode->llvmvar, "default"));
+    genlFnBody(gen, fnnode, clones[0]);
+    for (i = 0; i < GenMultiLevelCnt; ++i) {
+        clones[i + 1] = LLVMGetNamedFunction(gen->module, genlMultiName(namebuf, sizeof(namebuf), fnnode->llvmvar, genlMultiLevels[i].name));
+        if (clones[i + 1])
+            genlFnBody(gen, fnnode, clones[i + 1]);
+    }
+
+    LLVMValueRef svfn = gen->fn;
+    LLVMBuilderRef svbuilder = gen->builder;
+    MemTmpMark tmpmark = memTmpMark();
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(gen->context);
+    LLVMValueRef zero = LLVMConstInt(i32, 0, 0);
+    unsigned ptralign = LLVMABIAlignmentOfType(gen->datalayout, LLVMTypeOf(clones[0]));
+    gen->builder = LLVMCreateBuilder();
+
+    // The resolver: find what the CPU (and OS) supports, then keep and call the best clone
+    gen->fn = LLVMGetNamedFunction(gen->module, genlMultiName(namebuf, sizeof(namebuf), fnnode->llvmvar, "resolve"));
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(gen->context, gen->fn, "entry");
+    LLVMBasicBlockRef xgetbvblk = LLVMAppendBasicBlockInContext(gen->context, gen->fn, "xgetbv");
+    LLVMBasicBlockRef pickblk = LLVMAppendBasicBlockInContext(gen->context, gen->fn, "pick");
+    LLVMPositionBuilderAtEnd(gen->builder, entry);
+    LLVMValueRef maxleaf = LLVMBuildExtractValue(gen->builder, genlMultiCpuid(gen, 0), 0, "");
+    LLVMValueRef ecx1 = LLVMBuildExtractValue(gen->builder, genlMultiCpuid(gen, 1), 2, "");
+    LLVMValueRef ebx7 = LLVMBuildExtractValue(gen->builder, genlMultiCpuid(gen, 7), 1, "");
+    ebx7 = LLVMBuildSelect(gen->builder,
+        LLVMBuildICmp(gen->builder, LLVMIntUGE, maxleaf, LLVMConstInt(i32, 7, 0), ""), ebx7, zero, "");
+    // xgetbv faults unless the OS has enabled it
+    LLVMBuildCondBr(gen->builder, genlMultiHas(gen, ecx1, CpuidOsxsave), xgetbvblk, pickblk);
+    LLVMPositionBuilderAtEnd(gen->builder, xgetbvblk);
+    LLVMTypeRef xgetbvregs[2] = { i32, i32 };
+    LLVMTypeRef xgetbvtype = LLVMFunctionType(LLVMStructTypeInContext(gen->context, xgetbvregs, 2, 0), &i32, 1, 0);
+    LLVMValueRef xgetbv = LLVMConstInlineAsm(xgetbvtype, "xgetbv", "={ax},={dx},{cx}", 1, 0);
+    LLVMValueRef xcr0saved = LLVMBuildExtractValue(gen->builder, LLVMBuildCall(gen->builder, xgetbv, &zero, 1, ""), 0, "");
+    LLVMBuildBr(gen->builder, pickblk);
+    LLVMPositionBuilderAtEnd(gen->builder, pickblk);
+    LLVMValueRef xcr0 = LLVMBuildPhi(gen->builder, i32, "");
+    LLVMValueRef xcr0vals[2] = { zero, xcr0saved };
+    LLVMBasicBlockRef xcr0blks[2] = { entry, xgetbvblk };
+    LLVMAddIncoming(xcr0, xcr0vals, xcr0blks, 2);
+    LLVMValueRef best = clones[0];
+    for (i = 0; i < GenMultiLevelCnt; ++i) {
+        GenMultiLevel *level = &genlMultiLevels[i];
+        if (!clones[i + 1])
+            continue;
+        LLVMValueRef has = LLVMBuildAnd(gen->builder, genlMultiHas(gen, ecx1, level->ecx1), genlMultiHas(gen, ebx7, level->ebx7), "");
+        has = LLVMBuildAnd(gen->builder, has, genlMultiHas(gen, xcr0, level->xcr0), "");
+        best = LLVMBuildSelect(gen->builder, has, clones[i + 1], best, "");
+    }
+    // Racing resolvers store the same pointer
+    LLVMValueRef store = LLVMBuildStore(gen->builder, best, fnptr);
+    LLVMSetOrdering(store, LLVMAtomicOrderingMonotonic);
+    LLVMSetAlignment(store, ptralign);
+    genlMultiTailCall(gen, best);
+
+    // The thunk: call whatever the pointer holds
+    gen->fn = fnnode->llvmvar;
+    LLVMPositionBuilderAtEnd(gen->builder, LLVMAppendBasicBlockInContext(gen->context, gen->fn, "entry"));
+    LLVMValueRef load = LLVMBuildLoad(gen->builder, fnptr, "");
+    LLVMSetOrdering(load, LLVMAtomicOrderingMonotonic);
+    LLVMSetAlignment(load, ptralign);
+    genlMultiTailCall(gen, load);
+
+    LLVMDisposeBuilder(gen->builder);
+    memTmpRelease(tmpmark);
+    gen->builder = svbuilder;
+    gen->fn = svfn;
+}
@@ -0,0 +1,639 @@
+/** Parallel LLVM backend: optimize and emit module partitions on worker threads
+ * @file
+ *
+ * The generated module is split by function into partitions. Each worker
+ * thread loads its own copy of the module (in its own LLVMContext) from bitcode,
+ * strips the bodies of functions owned by other partitions down to declarations,
+ * then optimizes and emits it as a separate object file. Partition 0 writes
+ * the usual <name>.o; partition k writes <name>.k.o.
+ *
+ * With --incremental, partitions are instead small units of functions, and
+ * only those whose objects are not in the object cache are compiled.
+ *
+ * A whole module's assembly listing is emitted the same way: from a copy
+ * loaded on a worker thread, while this thread emits its object.
+ * Every output is emitted into memory and written to its file whole.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../ir/nametbl.h"
+#include "../shared/error.h"
+#include "../shared/memory.h"
+#include "../coneopts.h"
+#include "../shared/fileio.h"
+#include "genllvm.h"
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Transforms/IPO.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Stack size for worker threads: LLVM's code generator recurses deeply
+#define GenPartStack (8u << 20)
+
+// With --incremental, a unit ends after a function whose name's hash has these bits clear
+#define GenIncrUnitMask 15
+
+// The work and results of one partition
+typedef struct GenPart {
+    LLVMMemoryBufferRef bitcode;    // Whole module, shared read-only by all workers
+    uint32_t *owner;    // Partition owning each defined function, in module order
+    uint32_t part;      // This partition's number
+    ConeOptions *opt;
+    LLVMTargetMachineRef machine;
+    char *objpath;
+    char *asmpath;
+    char *irpath;
+    char *err;          // First error, reported by the main thread after join
+} GenPart;
+
+// Count the instructions in a function definition, as an estimate of its backend cost
+static size_t genlPartFnSize(LLVMValueRef fn) {
+    size_t size = 0;
+    LLVMBasicBlockRef blk;
+    LLVMValueRef inst;
+    for (blk = LLVMGetFirstBasicBlock(fn); blk; blk = LLVMGetNextBasicBlock(blk))
+        for (inst = LLVMGetFirstInstruction(blk); inst; inst = LLVMGetNextInstruction(inst))
+            ++size;
+    return size;
+}
+
+// Turn a function definition into a declaration.
+// All uses of its instructions are dropped first, so nothing is erased while still in use.
+static void genlPartStripFn(LLVMValueRef fn) {
+    LLVMBasicBlockRef blk;
+    LLVMValueRef inst;
+    for (blk = LLVMGetFirstBasicBlock(fn); blk; blk = LLVMGetNextBasicBlock(blk))
+        for (inst = LLVMGetFirstInstruction(blk); inst; inst = LLVMGetNextInstruction(inst))
+            if (LLVMGetTypeKind(LLVMTypeOf(inst)) != LLVMVoidTypeKind)
+                LLVMReplaceAllUsesWith(inst, LLVMGetUndef(LLVMTypeOf(inst)));
+    for (blk = LLVMGetFirstBasicBlock(fn); blk; blk = LLVMGetNextBasicBlock(blk)) {
+        while ((inst = LLVMGetLastInstruction(blk)))
+            LLVMInstructionEraseFromParent(inst);
+    }
+    while ((blk = LLVMGetFirstBasicBlock(fn)))
+        LLVMDeleteBasicBlock(blk);
+    LLVMSetLinkage(fn, LLVMExternalLinkage);
+}
+
+// Keep only what this partition owns: its functions' bodies and, for partition 0,
+// the definitions of external global variables. Elsewhere, those globals become
+// available-externally, so their values are still known but not emitted again.
+// Internal and link-once globals are kept everywhere, and dropped by global DCE where unused.
+static void genlPartSelect(GenPart *part, LLVMModuleRef mod) {
+    LLVMValueRef fn, glo;
+    size_t fncnt = 0;
+    for (fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn)) {
+        if (LLVMIsDeclaration(fn))
+            continue;
+        if (part->owner[fncnt++] != part->part)
+            genlPartStripFn(fn);
+    }
+    if (part->part == 0)
+        return;
+    for (glo = LLVMGetFirstGlobal(mod); glo; glo = LLVMGetNextGlobal(glo)) {
+        if (!LLVMIsDeclaration(glo) && LLVMGetLinkage(glo) == LLVMExternalLinkage)
+            LLVMSetLinkage(glo, LLVMAvailableExternallyLinkage);
+    }
+}
+
+// Emit a module as an object or assembly file, into memory and then written whole.
+// Like LLVMTargetMachineEmitToFile, return nonzero (with an error message) if it fails.
+static LLVMBool genlEmitToFile(LLVMTargetMachineRef machine, LLVMModuleRef mod, char *path,
+    LLVMCodeGenFileType filetype, char **err) {
+    LLVMMemoryBufferRef buf;
+    if (LLVMTargetMachineEmitToMemoryBuffer(machine, mod, filetype, err, &buf) != 0)
+        return 1;
+    int ok = fileWrite(path, (char*)LLVMGetBufferStart(buf), LLVMGetBufferSize(buf));
+    LLVMDisposeMemoryBuffer(buf);
+    if (!ok) {
+        *err = LLVMCreateMessage(strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+// Remember a worker's first error. LLVM messages are copied, then disposed.
+static void genlPartErr(GenPart *part, char *what, char *err) {
+    if (!part->err) {
+        size_t len = strlen(what) + (err? strlen(err) : 0) + 3;
+        part->err = malloc(len);
+        snprintf(part->err, len, "%s: %s", what, err? err : "");
+    }
+    if (err)
+        LLVMDisposeMessage(err);
+}
+
+// Load, trim, optimize and emit one partition, entirely within its own context
+static void genlPartRun(GenPart *part) {
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef mod;
+    char *err = NULL;
+
+    if (LLVMParseBitcodeInContext2(context, part->bitcode, &mod)) {
+        genlPartErr(part, "Could not load partition", NULL);
+        LLVMContextDispose(context);
+        return;
+    }
+    genlPartSelect(part, mod);
+
+    if (part->machine)
+        genlTarget(mod, part->opt->triple, part->machine);
+    genlOptimize(mod, part->opt, part->machine);
+    LLVMPassManagerRef passmgr = LLVMCreatePassManager();
+    LLVMAddGlobalDCEPass(passmgr);     // Drop globals copied in but not used here
+    LLVMRunPassManager(passmgr, mod);
+    LLVMDisposePassManager(passmgr);
+
+    if (part->irpath && LLVMPrintModuleToFile(mod, part->irpath, &err) != 0)
+        genlPartErr(part, "Could not emit ir file", err);
+
+    if (part->machine) {
+        if (part->asmpath && genlEmitToFile(part->machine, mod, part->asmpath, LLVMAssemblyFile, &err) != 0)
+            genlPartErr(part, "Could not emit asm file", err);
+        if (genlEmitToFile(part->machine, mod, part->objpath, LLVMObjectFile, &err) != 0)
+            genlPartErr(part, "Could not emit obj file", err);
+    }
+
+    LLVMDisposeModule(mod);
+    LLVMContextDispose(context);
+}
+
+// Load a whole module and emit only its assembly, entirely within its own context
+static void genlPartAsm(GenPart *part) {
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef mod;
+    char *err = NULL;
+
+    if (LLVMParseBitcodeInContext2(context, part->bitcode, &mod)) {
+        genlPartErr(part, "Could not load module for asm file", NULL);
+        LLVMContextDispose(context);
+        return;
+    }
+    if (genlEmitToFile(part->machine, mod, part->asmpath, LLVMAssemblyFile, &err) != 0)
+        genlPartErr(part, "Could not emit asm file", err);
+    LLVMDisposeModule(mod);
+    LLVMContextDispose(context);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI genlPartThread(LPVOID arg) {
+    genlPartRun((GenPart *)arg);
+    return 0;
+}
+static DWORD WINAPI genlPartAsmThread(LPVOID arg) {
+    genlPartAsm((GenPart *)arg);
+    return 0;
+}
+#else
+static void *genlPartThread(void *arg) {
+    genlPartRun((GenPart *)arg);
+    return NULL;
+}
+static void *genlPartAsmThread(void *arg) {
+    genlPartAsm((GenPart *)arg);
+    return NULL;
+}
+#endif
+
+// Make the output path for a partition: <name>.<ext>, or <name>.<k>.<ext> after the first
+static char *genlPartPath(ConeOptions *opt, char *fname, uint32_t k, char *ext) {
+    char partfn[24];
+    if (k == 0)
+        return fileMakePath(opt->output, fname, ext);
+    snprintf(partfn, sizeof(partfn), "%u.%s", k, ext);
+    return fileMakePath(opt->output, fname, partfn);
+}
+
+// Name anonymous functions (e.g., closures), so every partition refers to them the same way
+static void genlPartNameAnon(LLVMModuleRef mod) {
+    LLVMValueRef fn;
+    size_t anoncnt = 0;
+    for (fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn)) {
+        size_t namelen;
+        LLVMGetValueName2(fn, &namelen);
+        if (namelen == 0) {
+            char anonname[32];
+            snprintf(anonname, sizeof(anonname), "__unnamed_%zu", ++anoncnt);
+            LLVMSetValueName2(fn, anonname, strlen(anonname));
+        }
+    }
+}
+
+// Prepare a partition's work, other than its target machine
+static void genlPartInit(GenPart *part, GenState *gen, LLVMMemoryBufferRef bitcode, uint32_t *owner,
+    uint32_t k, char *fname, char *objext, char *asmext) {
+    ConeOptions *opt = gen->opt;
+    part->bitcode = bitcode;
+    part->owner = owner;
+    part->part = k;
+    part->opt = opt;
+    part->machine = NULL;
+    part->objpath = genlPartPath(opt, fname, k, objext);
+    part->asmpath = opt->print_asm ? genlPartPath(opt, fname, k, asmext) : NULL;
+    part->irpath = opt->print_llvmir ? genlPartPath(opt, fname, k, "ir") : NULL;
+    part->err = NULL;
+}
+
+// Run partitions, up to opt->jobs at a time: the first of each batch on this thread,
+// the rest on workers. Target machines are not shared between threads,
+// so each worker gets its own, used for every batch.
+static void genlPartRunAll(GenState *gen, GenPart *parts, uint32_t nparts) {
+    uint32_t nslots = nparts < (uint32_t)gen->opt->jobs ? nparts : (uint32_t)gen->opt->jobs;
+    uint32_t first, k;
+    if (nslots == 0)
+        return;
+    LLVMTargetMachineRef *machines = memAllocBlk(nslots * sizeof(LLVMTargetMachineRef));
+    for (k = 0; k < nslots; ++k)
+        machines[k] = !gen->machine ? NULL : k == 0 ? gen->machine : genlCreateMachine(gen->opt);
+
+#ifdef _WIN32
+    HANDLE *threads = memAllocBlk(nslots * sizeof(HANDLE));
+#else
+    pthread_t *threads = memAllocBlk(nslots * sizeof(pthread_t));
+    char *started = memAllocBlk(nslots);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, GenPartStack);
+#endif
+    for (first = 0; first < nparts; first += nslots) {
+        uint32_t n = nparts - first < nslots ? nparts - first : nslots;
+        for (k = 0; k < n; ++k)
+            parts[first + k].machine = machines[k];
+#ifdef _WIN32
+        for (k = 1; k < n; ++k)
+            threads[k] = CreateThread(NULL, GenPartStack, genlPartThread, &parts[first + k], 0, NULL);
+        genlPartRun(&parts[first]);
+        for (k = 1; k < n; ++k) {
+            if (threads[k]) {
+                WaitForSingleObject(threads[k], INFINITE);
+                CloseHandle(threads[k]);
+            }
+            else
+                genlPartRun(&parts[first + k]);
+        }
+#else
+        for (k = 1; k < n; ++k)
+            started[k] = pthread_create(&threads[k], &attr, genlPartThread, &parts[first + k]) == 0;
+        genlPartRun(&parts[first]);
+        for (k = 1; k < n; ++k) {
+            if (started[k])
+                pthread_join(threads[k], NULL);
+            else
+                genlPartRun(&parts[first + k]);
+        }
+#endif
+    }
+#ifndef _WIN32
+    pthread_attr_destroy(&attr);
+#endif
+
+    for (k = 1; k < nslots; ++k) {
+        if (machines[k])
+            LLVMDisposeTargetMachine(machines[k]);
+    }
+}
+
+// Report a partition's error, if any. Return 1 if it succeeded.
+static int genlPartReport(GenPart *part) {
+    if (!part->err)
+        return 1;
+    errorMsg(ErrorGenErr, "%s", part->err);
+    free(part->err);
+    part->err = NULL;
+    return 0;
+}
+
+// Emit the optimized module's object file and, when asmpath is given, its assembly.
+// Both would otherwise run the whole backend one after the other. Instead, the
+// assembly is emitted from a copy of the module, loaded from bitcode into a context
+// of its own and given a target machine of its own, on a worker thread.
+void genlOut(GenState *gen, char *objpath, char *asmpath) {
+    GenPart asmpart;
+    char *err;
+    int started = 0;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+
+    if (asmpath) {
+        memset(&asmpart, 0, sizeof(asmpart));
+        asmpart.bitcode = LLVMWriteBitcodeToMemoryBuffer(gen->module);
+        asmpart.opt = gen->opt;
+        asmpart.machine = genlCreateMachine(gen->opt);
+        asmpart.asmpath = asmpath;
+        if (!asmpart.machine)
+            asmpart.machine = gen->machine;
+        else {
+#ifdef _WIN32
+            thread = CreateThread(NULL, GenPartStack, genlPartAsmThread, &asmpart, 0, NULL);
+            started = thread != NULL;
+#else
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            pthread_attr_setstacksize(&attr, GenPartStack);
+            started = pthread_create(&thread, &attr, genlPartAsmThread, &asmpart) == 0;
+            pthread_attr_destroy(&attr);
+#endif
+        }
+    }
+
+    if (genlEmitToFile(gen->machine, gen->module, objpath, LLVMObjectFile, &err) != 0) {
+        errorMsg(ErrorGenErr, "Could not emit obj file: %s", err);
+        LLVMDisposeMessage(err);
+    }
+
+    if (asmpath) {
+        if (started) {
+#ifdef _WIN32
+            WaitForSingleObject(thread, INFINITE);
+            CloseHandle(thread);
+#else
+            pthread_join(thread, NULL);
+#endif
+        }
+        else
+            genlPartAsm(&asmpart);
+        genlPartReport(&asmpart);
+        if (asmpart.machine != gen->machine)
+            LLVMDisposeTargetMachine(asmpart.machine);
+        LLVMDisposeMemoryBuffer(asmpart.bitcode);
+    }
+}
+
+// Optimize and emit the generated module as opt->jobs partitions, concurrently.
+// The module is consumed (disposed of) in the process.
+void genlParallel(GenState *gen, char *fname, char *objext, char *asmext) {
+    ConeOptions *opt = gen->opt;
+    LLVMValueRef fn;
+    size_t fncnt = 0, total = 0, sofar = 0;
+    uint32_t nparts, k;
+
+    // Balance partitions by instruction count, keeping neighbouring functions together
+    for (fn = LLVMGetFirstFunction(gen->module); fn; fn = LLVMGetNextFunction(fn)) {
+        if (!LLVMIsDeclaration(fn)) {
+            total += genlPartFnSize(fn);
+            ++fncnt;
+        }
+    }
+    nparts = (uint32_t)(fncnt < (size_t)opt->jobs ? fncnt : (size_t)opt->jobs);
+    if (nparts == 0)
+        nparts = 1;
+    uint32_t *owner = memAllocBlk((fncnt + 1) * sizeof(uint32_t));
+    fncnt = 0;
+    for (fn = LLVMGetFirstFunction(gen->module); fn; fn = LLVMGetNextFunction(fn)) {
+        if (LLVMIsDeclaration(fn))
+            continue;
+        owner[fncnt++] = (uint32_t)(total ? sofar * nparts / total : 0);
+        sofar += genlPartFnSize(fn);
+    }
+
+    genlPartNameAnon(gen->module);
+    LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(gen->module);
+    LLVMDisposeModule(gen->module);
+
+    GenPart *parts = memAllocBlk(nparts * sizeof(GenPart));
+    for (k = 0; k < nparts; ++k)
+        genlPartInit(&parts[k], gen, bitcode, owner, k, fname, objext, asmext);
+    genlPartRunAll(gen, parts, nparts);
+    for (k = 0; k < nparts; ++k)
+        genlPartReport(&parts[k]);
+    LLVMDisposeMemoryBuffer(bitcode);
+}
+
+// Mix a hash into another, order-sensitively
+static uint64_t genlPartMix(uint64_t hash, uint64_t more) {
+    hash ^= more + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// The module's numbered metadata nodes (!N = ...), and the numbering of those reached
+// from the text being hashed, in the order first referenced
+typedef struct GenIncrMeta {
+    char **node;        // Each node's text, after "!N = ", or NULL
+    uint32_t *local;    // Each node's number in the text being hashed, from 1, or 0 if not reached
+    uint32_t *queue;    // Nodes reached, by local number - 1
+    uint32_t nnodes;
+    uint32_t nlocal;
+} GenIncrMeta;
+
+// Prepare a numbering of the given metadata nodes
+static void genlIncrMetaInit(GenIncrMeta *meta, char **node, uint32_t nnodes) {
+    meta->node = node;
+    meta->nnodes = nnodes;
+    meta->local = memAllocBlk((nnodes + 1) * sizeof(uint32_t));
+    memset(meta->local, 0, (nnodes + 1) * sizeof(uint32_t));
+    meta->queue = memAllocBlk((nnodes + 1) * sizeof(uint32_t));
+    meta->nlocal = 0;
+}
+
+// Mix text into a hash, with each metadata reference (!N) replaced by the node's
+// local number. The module numbers its metadata nodes in one sequence, so any
+// edit renumbers every node after it. Local numbers depend only on the text itself.
+static uint64_t genlIncrHashText(GenIncrMeta *meta, uint64_t hash, char *text, size_t len) {
+    char *end = text + len, *from = text, *p;
+    int quoted = 0;
+    for (p = text; p < end; ++p) {
+        if (*p == '"')
+            quoted = !quoted;
+        else if (*p == '!' && !quoted && p + 1 < end && isdigit((unsigned char)p[1])) {
+            char *nbrend;
+            unsigned long nbr = strtoul(p + 1, &nbrend, 10);
+            if (nbr >= meta->nnodes || !meta->node[nbr])
+                continue;
+            if (meta->local[nbr] == 0) {
+                meta->queue[meta->nlocal++] = (uint32_t)nbr;
+                meta->local[nbr] = meta->nlocal;
+            }
+            hash = genlPartMix(hash, nametblHash(from, (size_t)(p + 1 - from)));
+            hash = genlPartMix(hash, meta->local[nbr]);
+            from = nbrend;
+            p = nbrend - 1;
+        }
+    }
+    if (from < end)
+        hash = genlPartMix(hash, nametblHash(from, (size_t)(end - from)));
+    return hash;
+}
+
+// Mix the contents of the metadata nodes reached so far into a hash, including
+// the nodes they reach in turn. Then forget the numbering, ready for other text.
+static uint64_t genlIncrHashMeta(GenIncrMeta *meta, uint64_t hash) {
+    uint32_t k;
+    for (k = 0; k < meta->nlocal; ++k) {    // nlocal grows as nodes reach others
+        char *node = meta->node[meta->queue[k]];
+        char *eol = strchr(node, '\n');
+        hash = genlIncrHashText(meta, hash, node, eol ? (size_t)(eol - node) : strlen(node));
+    }
+    for (k = 0; k < meta->nlocal; ++k)
+        meta->local[meta->queue[k]] = 0;
+    meta->nlocal = 0;
+    return hash;
+}
+
+// Emit the generated module as units of neighbouring functions, each its own object,
+// optimized and compiled only if the object cache does not already hold it.
+// A unit's fingerprint is a hash of its functions' LLVM IR and the metadata they
+// reach (such as debug locations), mixed with a hash of everything else in the module:
+// types, global variables and function declarations, which carry the signatures its
+// functions depend on. Metadata is hashed by content, not by its number in the module.
+// After an edit to one function's body, only the unit holding it is recompiled, unless
+// the edit moves source lines: debug locations below it then change too.
+// Units end after a function whose name hashes to 0 under GenIncrUnitMask, so adding
+// or removing a function moves only nearby unit boundaries. The module is consumed.
+void genlIncremental(GenState *gen, char *fname, char *objext, char *asmext) {
+    ConeOptions *opt = gen->opt;
+    LLVMValueRef fn;
+    size_t fncnt = 0;
+    uint32_t nunits = 0, nmisses = 0, k;
+
+    genlPartNameAnon(gen->module);
+    for (fn = LLVMGetFirstFunction(gen->module); fn; fn = LLVMGetNextFunction(fn)) {
+        if (!LLVMIsDeclaration(fn))
+            ++fncnt;
+    }
+    uint32_t *owner = memAllocBlk((fncnt + 1) * sizeof(uint32_t));
+    uint64_t *unithash = memAllocBlk((fncnt + 1) * sizeof(uint64_t));
+    size_t *unitsize = memAllocBlk((fncnt + 1) * sizeof(size_t));
+    memset(unithash, 0, (fncnt + 1) * sizeof(uint64_t));
+    memset(unitsize, 0, (fncnt + 1) * sizeof(size_t));
+
+    // Find the numbered metadata nodes, which follow everything else
+    char *text = LLVMPrintModuleToString(gen->module);
+    char *line, *next;
+    uint32_t nnodes = 0;
+    for (line = text; *line; line = next) {
+        next = strchr(line, '\n');
+        next = next ? next + 1 : line + strlen(line);
+        if (*line == '!' && isdigit((unsigned char)line[1]))
+            ++nnodes;
+    }
+    char **node = memAllocBlk((nnodes + 1) * sizeof(char*));
+    memset(node, 0, (nnodes + 1) * sizeof(char*));
+    for (line = text; *line; line = next) {
+        next = strchr(line, '\n');
+        next = next ? next + 1 : line + strlen(line);
+        if (*line == '!' && isdigit((unsigned char)line[1])) {
+            char *nbrend;
+            unsigned long nbr = strtoul(line + 1, &nbrend, 10);
+            if (nbr < nnodes && strncmp(nbrend, " = ", 3) == 0)
+                node[nbr] = nbrend + 3;
+        }
+    }
+    GenIncrMeta unitmeta, restmeta;
+    genlIncrMetaInit(&unitmeta, node, nnodes);
+    genlIncrMetaInit(&restmeta, node, nnodes);
+
+    // Split the module's text into function definitions (define ... to }), whose
+    // hashes go to their units, and the rest. Comments are left out, and metadata
+    // nodes are hashed only as reached from the text that uses them.
+    uint64_t rest = 0;
+    char *deflinep = NULL;
+    size_t defno = 0;
+    fn = LLVMGetFirstFunction(gen->module);
+    for (line = text; *line; line = next) {
+        char *eol = strchr(line, '\n');
+        next = eol ? eol + 1 : line + strlen(line);
+        if (deflinep) {
+            if (*line == '}' && (next - line == 1 || line[1] == '\n' || line[1] == '\0')) {
+                while (fn && LLVMIsDeclaration(fn))
+                    fn = LLVMGetNextFunction(fn);
+                if (defno < fncnt) {
+                    owner[defno] = nunits;
+                    unithash[nunits] = genlIncrHashText(&unitmeta, unitsize[nunits] ? unithash[nunits] : 0,
+                        deflinep, (size_t)(next - deflinep));
+                    unitsize[nunits] += (size_t)(next - deflinep);
+                    size_t namelen;
+                    const char *name = fn ? LLVMGetValueName2(fn, &namelen) : "";
+                    if (!fn || (nametblHash((char*)name, namelen) & GenIncrUnitMask) == 0) {
+                        unithash[nunits] = genlIncrHashMeta(&unitmeta, unithash[nunits]);
+                        ++nunits;
+                    }
+                    ++defno;
+                }
+                if (fn)
+                    fn = LLVMGetNextFunction(fn);
+                deflinep = NULL;
+            }
+        }
+        else if (strncmp(line, "define ", 7) == 0)
+            deflinep = line;
+        else if (*line != ';' && *line != '\n' && !(*line == '!' && isdigit((unsigned char)line[1])))
+            rest = genlIncrHashText(&restmeta, rest, line, (size_t)(next - line));
+    }
+    if (deflinep) {
+        // An unfinished definition: keep its text, for the fallback below
+        unithash[nunits] = genlIncrHashText(&unitmeta, unitsize[nunits] ? unithash[nunits] : 0,
+            deflinep, strlen(deflinep));
+        unitsize[nunits] += strlen(deflinep);
+    }
+    if (unitsize[nunits])
+        unithash[nunits] = genlIncrHashMeta(&unitmeta, unithash[nunits]);
+    rest = genlIncrHashMeta(&restmeta, rest);
+    LLVMDisposeMessage(text);
+    if (defno < fncnt || deflinep) {
+        // Not split as expected: treat the module as one unit, keyed on all of it
+        uint64_t all = genlPartMix(rest, (uint64_t)fncnt);
+        size_t allsize = 0;
+        for (k = 0; k <= nunits; ++k) {
+            if (unitsize[k]) {
+                all = genlPartMix(all, unithash[k]);
+                allsize += unitsize[k];
+            }
+        }
+        for (k = 0; k < fncnt; ++k)
+            owner[k] = 0;
+        unithash[0] = all;
+        unitsize[0] = allsize;
+        nunits = 1;
+    }
+    else if (fncnt == 0 || unitsize[nunits])
+        ++nunits;    // The last unit, or the only (empty) one
+
+    // Copy units from the cache, and prepare to compile the rest
+    GenPart *parts = memAllocBlk(nunits * sizeof(GenPart));
+    char **keys = memAllocBlk(nunits * sizeof(char*));
+    LLVMMemoryBufferRef bitcode = NULL;
+    for (k = 0; k < nunits; ++k) {
+        GenPart *part = &parts[nmisses];
+        genlPartInit(part, gen, NULL, owner, k, fname, objext, asmext);
+        // Only the first unit defines external global variables
+        uint64_t hash = genlPartMix(genlPartMix(rest, unithash[k]), k == 0);
+        keys[nmisses] = genlCacheKeyOf(opt, hash, unitsize[k]);
+        if (genlCacheGet(opt, keys[nmisses], part->objpath, objext, part->asmpath, asmext))
+            continue;
+        if (!bitcode)
+            bitcode = LLVMWriteBitcodeToMemoryBuffer(gen->module);
+        part->bitcode = bitcode;
+        ++nmisses;
+    }
+    LLVMDisposeModule(gen->module);
+
+    // Remove objects left over from builds with more units
+    for (k = nunits; remove(genlPartPath(opt, fname, k, objext)) == 0; ++k)
+        remove(genlPartPath(opt, fname, k, asmext));
+
+    genlPartRunAll(gen, parts, nmisses);
+    for (k = 0; k < nmisses; ++k) {
+        if (genlPartReport(&parts[k]) && parts[k].machine)
+            genlCachePut(opt, keys[k], parts[k].objpath, objext, parts[k].asmpath, asmext);
+    }
+    if (bitcode)
+        LLVMDisposeMemoryBuffer(bitcode);
+}
@@ -32,8 +32,8 @@ LLVMBasicBlockRef genlInsertBlock(GenState *gen, char *name) {
 
 }
 
-// Generate a loop block
-LLVMValueRef genlLoop(GenState *gen, LoopNode *loopnode) {
+// Generate one copy of a loop
+static LLVMValueRef genlLoopCopy(GenState *gen, LoopNode *loopnode) {
     LLVMBasicBlockRef loopbeg, loopend;
 
     loopend = genlInsertBlock(gen, "loopend");
@@ -49,8 +49,8 @@ LLVMValueRef genlLoop(GenState *gen, LoopNode *loopnode) {
     loopstate->loopbeg = loopbeg;
     loopstate->loopend = loopend;
     if (loopnode->vtype->tag != VoidTag) {
-        loopstate->loopPhis = (LLVMValueRef*)memAllocBlk(sizeof(LLVMValueRef) * loopnode->breaks->used);
-        loopstate->loopBlks = (LLVMBasicBlockRef*)memAllocBlk(sizeof(LLVMBasicBlockRef) * loopnode->breaks->used);
+        loopstate->loopPhis = (LLVMValueRef*)memAllocTmp(sizeof(LLVMValueRef) * loopnode->breaks->used);
+        loopstate->loopBlks = (LLVMBasicBlockRef*)memAllocTmp(sizeof(LLVMBasicBlockRef) * loopnode->breaks->used);
         loopstate->loopPhiCnt = 0;
     }
     ++gen->loopstackcnt;
@@ -70,6 +70,76 @@ LLVMValueRef genlLoop(GenState *gen, LoopNode *loopnode) {
     return NULL;
 }
 
+// Generate the check, done before the loop, that its hoisted indexes are all in bounds:
+// no index reaches the loop's limit, so each array's count must be at least that limit
+static LLVMValueRef genlLoopBoundsOk(GenState *gen, LoopNode *loopnode) {
+    LLVMValueRef limit = genlExpr(gen, loopnode->limit);
+    LLVMTypeRef usize = genlUsize(gen);
+    int widen = LLVMGetIntTypeWidth(LLVMTypeOf(limit)) > LLVMGetIntTypeWidth(usize);
+    if (!widen)
+        limit = LLVMBuildZExt(gen->builder, limit, usize, "");
+    LLVMValueRef inbounds = NULL;
+    uint32_t cnt;
+    INode **nodesp;
+    for (nodesFor(loopnode->hoisted, cnt, nodesp)) {
+        FnCallNode *fncall = (FnCallNode *)*nodesp;
+        INode *objtype = iexpGetTypeDcl(fncall->objfn);
+        LLVMValueRef count;
+        if (objtype->tag == ArrayTag)
+            count = LLVMConstInt(usize, ((ArrayNode*)objtype)->size, 0);
+        else {
+            INode *arrref = objtype->tag == ArrayDerefTag ? ((DerefNode *)fncall->objfn)->exp : fncall->objfn;
+            count = LLVMBuildExtractValue(gen->builder, genlExpr(gen, arrref), 1, "count");
+        }
+        if (widen)
+            count = LLVMBuildZExt(gen->builder, count, LLVMTypeOf(limit), "");
+        LLVMValueRef fits = LLVMBuildICmp(gen->builder, LLVMIntULE, limit, count, "");
+        inbounds = inbounds ? LLVMBuildAnd(gen->builder, inbounds, fits, "") : fits;
+    }
+    return inbounds;
+}
+
+// Generate a loop block
+// When checks of its array indexes are hoisted, two copies of the loop are generated:
+// one without those checks, run when the check before the loop shows they cannot fail,
+// and one with them. Unoptimized builds just keep the checks in the loop.
+// Only a loop with no such loop inside it hoists checks, so no body is copied more than twice.
+LLVMValueRef genlLoop(GenState *gen, LoopNode *loopnode) {
+    if (loopnode->hoisted == NULL || gen->opt->optlevel == 0)
+        return genlLoopCopy(gen, loopnode);
+
+    LLVMValueRef inbounds = genlLoopBoundsOk(gen, loopnode);
+    LLVMBasicBlockRef loopjoin = genlInsertBlock(gen, "loopjoin");
+    LLVMBasicBlockRef checkedblk = genlInsertBlock(gen, "loopchecked");
+    LLVMBasicBlockRef inboundsblk = genlInsertBlock(gen, "loopinbounds");
+    genlBranchLikely(gen, LLVMBuildCondBr(gen->builder, inbounds, inboundsblk, checkedblk));
+
+    uint32_t cnt;
+    INode **nodesp;
+    LLVMValueRef vals[2];
+    LLVMBasicBlockRef blks[2];
+    LLVMPositionBuilderAtEnd(gen->builder, inboundsblk);
+    for (nodesFor(loopnode->hoisted, cnt, nodesp))
+        (*nodesp)->flags |= FlagInBounds;
+    vals[0] = genlLoopCopy(gen, loopnode);
+    for (nodesFor(loopnode->hoisted, cnt, nodesp))
+        (*nodesp)->flags &= ~FlagInBounds;
+    blks[0] = LLVMGetInsertBlock(gen->builder);
+    LLVMBuildBr(gen->builder, loopjoin);
+
+    LLVMPositionBuilderAtEnd(gen->builder, checkedblk);
+    vals[1] = genlLoopCopy(gen, loopnode);
+    blks[1] = LLVMGetInsertBlock(gen->builder);
+    LLVMBuildBr(gen->builder, loopjoin);
+
+    LLVMPositionBuilderAtEnd(gen->builder, loopjoin);
+    if (vals[0] == NULL)
+        return NULL;
+    LLVMValueRef phi = LLVMBuildPhi(gen->builder, LLVMTypeOf(vals[0]), "loopval");
+    LLVMAddIncoming(phi, vals, blks, 2);
+    return phi;
+}
+
 // Generate a return statement
 void genlReturn(GenState *gen, ReturnNode *node) {
     if (node->exp != noValue) {
@@ -58,8 +58,9 @@ void genlVtableImpl(GenState *gen, VtableImpl *impl, LLVMTypeRef vtableRef) {
 
 // Generate a vtable type
 void genlVtable(GenState *gen, Vtable *vtable) {
+    MemTmpMark tmpmark = memTmpMark();
     uint32_t fieldcnt = vtable->methfld->used;
-    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocBlk(fieldcnt * sizeof(LLVMTypeRef));
+    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocTmp(fieldcnt * sizeof(LLVMTypeRef));
     LLVMTypeRef *field_type_ptr = field_types;
 
     // Declare vtable's fields
@@ -70,7 +71,7 @@ void genlVtable(GenState *gen, Vtable *vtable) {
             // Generate a pointer to function signature
             // Note: parm types are not specified to avoid LLVM type check errors on self parm
             FnSigNode *fnsig = (FnSigNode*)itypeGetTypeDcl(((FnDclNode *)*nodesp)->vtype);
-            LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocBlk(fnsig->parms->used * sizeof(LLVMTypeRef));
+            LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocTmp(fnsig->parms->used * sizeof(LLVMTypeRef));
             LLVMTypeRef *parm = param_types;
             INode **nodesp;
             uint32_t cnt;
@@ -97,7 +98,7 @@ void genlVtable(GenState *gen, Vtable *vtable) {
 
     // Build all the vtable globals that implement the vtable
     // as well as an array pointing to all these vtables
-    LLVMValueRef *vtables = (LLVMValueRef *)memAllocBlk(vtable->impl->used * sizeof(LLVMValueRef *));
+    LLVMValueRef *vtables = (LLVMValueRef *)memAllocTmp(vtable->impl->used * sizeof(LLVMValueRef *));
     LLVMValueRef *vtablesp = vtables;
     for (nodesFor(vtable->impl, cnt, nodesp)) {
         genlVtableImpl(gen, (VtableImpl*)*nodesp, vtableRef);
@@ -119,6 +120,7 @@ void genlVtable(GenState *gen, Vtable *vtable) {
     LLVMStructSetBody(virtref, vreffields, 2, 0);
     vtable->llvmvtable = vtableRef;
     vtable->llvmreftype = virtref;
+    memTmpRelease(tmpmark);
 }
 
 // Generate a LLVMTypeRef for a struct, based on its fields and alignment
@@ -127,7 +129,8 @@ LLVMTypeRef genlStructType(GenState *gen, char *name, StructNode *strnode) {
     INode **nodesp;
     uint32_t cnt;
     uint32_t fieldcnt = strnode->fields.used;
-    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocBlk(fieldcnt * sizeof(LLVMTypeRef));
+    MemTmpMark tmpmark = memTmpMark();
+    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocTmp(fieldcnt * sizeof(LLVMTypeRef));
     LLVMTypeRef *field_type_ptr = field_types;
     for (nodelistFor(&strnode->fields, cnt, nodesp)) {
         *field_type_ptr++ = genlType(gen, ((FieldDclNode *)*nodesp)->vtype);
@@ -135,6 +138,7 @@ LLVMTypeRef genlStructType(GenState *gen, char *name, StructNode *strnode) {
     LLVMTypeRef structype = LLVMStructCreateNamed(gen->context, name);
     if (fieldcnt > 0)
         LLVMStructSetBody(structype, field_types, fieldcnt, 0);
+    memTmpRelease(tmpmark);
 
     return structype;
 }
@@ -300,7 +304,8 @@ LLVMTypeRef _genlType(GenState *gen, char *name, INode *typ) {
     {
         // Build typeref from function signature
         FnSigNode *fnsig = (FnSigNode*)typ;
-        LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocBlk(fnsig->parms->used * sizeof(LLVMTypeRef));
+        MemTmpMark tmpmark = memTmpMark();
+        LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocTmp(fnsig->parms->used * sizeof(LLVMTypeRef));
         LLVMTypeRef *parm = param_types;
         INode **nodesp;
         uint32_t cnt;
@@ -308,7 +313,9 @@ LLVMTypeRef _genlType(GenState *gen, char *name, INode *typ) {
             assert((*nodesp)->tag == VarDclTag);
             *parm++ = genlType(gen, ((IExpNode *)*nodesp)->vtype);
         }
-        return LLVMFunctionType(genlType(gen, fnsig->rettype), param_types, fnsig->parms->used, 0);
+        LLVMTypeRef fntype = LLVMFunctionType(genlType(gen, fnsig->rettype), param_types, fnsig->parms->used, 0);
+        memTmpRelease(tmpmark);
+        return fntype;
     }
 
     case StructTag:
@@ -348,12 +355,15 @@ LLVMTypeRef _genlType(GenState *gen, char *name, INode *typ) {
         INode **nodesp;
         uint32_t cnt;
         uint32_t propcount = tuple->types->used;
-        LLVMTypeRef *typerefs = (LLVMTypeRef *)memAllocBlk(propcount * sizeof(LLVMTypeRef));
+        MemTmpMark tmpmark = memTmpMark();
+        LLVMTypeRef *typerefs = (LLVMTypeRef *)memAllocTmp(propcount * sizeof(LLVMTypeRef));
         LLVMTypeRef *typerefp = typerefs;
         for (nodesFor(tuple->types, cnt, nodesp)) {
             *typerefp++ = genlType(gen, *nodesp);
         }
-        return LLVMStructTypeInContext(gen->context, typerefs, propcount, 0);
+        LLVMTypeRef tupletype = LLVMStructTypeInContext(gen->context, typerefs, propcount, 0);
+        memTmpRelease(tmpmark);
+        return tupletype;
     }
 
     case ArrayTag:
@@ -392,6 +402,15 @@ LLVMTypeRef genlType(GenState *gen, INode *typ) {
                 if ((*nodesp)->tag == FnDclTag)
                     genlGloFnName(gen, (FnDclNode*)*nodesp);
             }
+            // A region's methods run on every allocation and free, so they should be inlined there
+            if (dcltype->tag == RegionTag) {
+                unsigned inlinekind = LLVMGetEnumAttributeKindForName("inlinehint", 10);
+                for (nodelistFor(&tnode->nodelist, cnt, nodesp)) {
+                    if ((*nodesp)->tag == FnDclTag && ((FnDclNode*)*nodesp)->llvmvar)
+                        LLVMAddAttributeAtIndex(((FnDclNode*)*nodesp)->llvmvar, LLVMAttributeFunctionIndex,
+                            LLVMCreateEnumAttribute(gen->context, inlinekind, 0));
+                }
+            }
             // Now generate the code for each method
             for (nodelistFor(&tnode->nodelist, cnt, nodesp)) {
                 if ((*nodesp)->tag == FnDclTag)
@@ -400,6 +419,13 @@ LLVMTypeRef genlType(GenState *gen, INode *typ) {
         }
         return typeref;
     }
+    else if (dcltype->flags & InternedType) {
+        // An interned structural type is one node shared by all its uses, so memoize it too
+        ITypeNode *itype = (ITypeNode*)dcltype;
+        if (itype->llvmtype == NULL)
+            itype->llvmtype = _genlType(gen, "", dcltype);
+        return itype->llvmtype;
+    }
     else
         return _genlType(gen, "", dcltype);
 }
@@ -0,0 +1,265 @@
+/** The bounds analysis pass
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "ir.h"
+
+// What is known about a loop of the form `while var < limit`
+typedef struct BoundsLoop {
+    LoopNode *loop;
+    VarDclNode *var;      // The loop's index variable
+    INode *limit;         // The bound the index variable is below
+    VarDclNode *countof;  // The slice whose count is the limit (or NULL)
+    int innerhoist;       // Whether a loop inside this one has hoisted checks
+} BoundsLoop;
+
+// The current function's locals whose address escapes, so they may change unseen
+static Nodes *boundsEscaped;
+// Borrows that only feed an in-place operation (x++, x += y), which do not escape
+static Nodes *boundsInPlace;
+
+// Is the node in the list?
+static int boundsHas(Nodes *nodes, INode *node) {
+    uint32_t cnt;
+    INode **nodesp;
+    for (nodesFor(nodes, cnt, nodesp)) {
+        if (*nodesp == node)
+            return 1;
+    }
+    return 0;
+}
+
+// Return the declaration of the local variable a node names, or NULL
+static VarDclNode *boundsLocalVar(INode *node) {
+    if (node->tag != VarNameUseTag)
+        return NULL;
+    VarDclNode *var = (VarDclNode *)((NameUseNode *)node)->dclnode;
+    return var->tag == VarDclTag && var->scope > 0 ? var : NULL;
+}
+
+// Return the intrinsic operation a node calls, or -1 if it is not one
+static int16_t boundsIntrinsic(INode *node) {
+    if (node->tag != FnCallTag)
+        return -1;
+    INode *objfn = ((FnCallNode *)node)->objfn;
+    if (objfn->tag != VarNameUseTag)
+        return -1;
+    FnDclNode *fndcl = (FnDclNode *)((NameUseNode *)objfn)->dclnode;
+    if (fndcl->tag != FnDclTag || fndcl->value == NULL || fndcl->value->tag != IntrinsicTag)
+        return -1;
+    return ((IntrinsicNode *)fndcl->value)->intrinsicFn;
+}
+
+// Collect the function's loops and the locals whose address escapes
+static void boundsScan(INode *node, void *ctx) {
+    switch (node->tag) {
+    case LoopTag:
+        nodesAdd((Nodes **)ctx, node);
+        break;
+    case VarDclTag: {
+        // `x += y` is lowered to `{imm _ = &mut x; *_ = *_ + y}`
+        VarDclNode *var = (VarDclNode *)node;
+        if (var->namesym == anonName && var->value && var->value->tag == BorrowTag)
+            nodesAdd(&boundsInPlace, var->value);
+        break;
+    }
+    case FnCallTag: {
+        // x++ and x-- borrow x for the intrinsic
+        Nodes *args = ((FnCallNode *)node)->args;
+        if (boundsIntrinsic(node) >= 0 && args && args->used > 0 && nodesGet(args, 0)->tag == BorrowTag)
+            nodesAdd(&boundsInPlace, nodesGet(args, 0));
+        break;
+    }
+    case BorrowTag: {
+        VarDclNode *var = boundsLocalVar(((BorrowNode *)node)->exp);
+        if (var && !boundsHas(boundsInPlace, node))
+            nodesAdd(&boundsEscaped, (INode *)var);
+        break;
+    }
+    }
+}
+
+// What boundsChanged looks for, and whether it was found
+typedef struct BoundsChange {
+    VarDclNode *var;
+    int changed;
+} BoundsChange;
+
+static void boundsChange(INode *node, void *ctx) {
+    BoundsChange *change = (BoundsChange *)ctx;
+    if (node->tag == AssignTag) {
+        INode *lval = ((AssignNode *)node)->lval;
+        if (lval->tag == VTupleTag) {
+            uint32_t cnt;
+            INode **nodesp;
+            for (nodesFor(((VTupleNode *)lval)->values, cnt, nodesp)) {
+                if (boundsLocalVar(*nodesp) == change->var)
+                    change->changed = 1;
+            }
+        }
+        else if (boundsLocalVar(lval) == change->var)
+            change->changed = 1;
+    }
+    else if (node->tag == BorrowTag && boundsLocalVar(((BorrowNode *)node)->exp) == change->var)
+        change->changed = 1;
+}
+
+// Might the tree change the local variable's value?
+static int boundsChanged(INode *node, VarDclNode *var) {
+    BoundsChange change;
+    change.var = var;
+    change.changed = 0;
+    return !inodeWalk(node, boundsChange, &change) || change.changed;
+}
+
+// Does the local variable hold the same value throughout the loop?
+static int boundsInvariant(LoopNode *loop, VarDclNode *var) {
+    return !boundsHas(boundsEscaped, (INode *)var) && !boundsChanged(loop->blk, var);
+}
+
+// Fill in bloop if the loop begins `while var < limit` (with an unchanging limit)
+static int boundsLoopLimit(LoopNode *loop, BoundsLoop *bloop) {
+    Nodes *stmts = ((BlockNode *)loop->blk)->stmts;
+    if (stmts->used == 0 || nodesGet(stmts, 0)->tag != IfTag)
+        return 0;
+    Nodes *condblk = ((IfNode *)nodesGet(stmts, 0))->condblk;
+    if (condblk->used != 2 || nodesGet(condblk, 0)->tag != NotLogicTag || nodesGet(condblk, 1)->tag != BlockTag)
+        return 0;
+    Nodes *exitstmts = ((BlockNode *)nodesGet(condblk, 1))->stmts;
+    if (exitstmts->used == 0 || nodesGet(exitstmts, exitstmts->used - 1)->tag != BreakTag)
+        return 0;
+
+    INode *cond = ((LogicNode *)nodesGet(condblk, 0))->lexp;
+    if (boundsIntrinsic(cond) != LtIntrinsic)
+        return 0;
+    Nodes *args = ((FnCallNode *)cond)->args;
+    VarDclNode *var = boundsLocalVar(nodesGet(args, 0));
+    if (var == NULL || iexpGetTypeDcl((INode *)var)->tag != UintNbrTag
+        || boundsHas(boundsEscaped, (INode *)var) || boundsChanged(cond, var))
+        return 0;
+
+    INode *limit = nodesGet(args, 1);
+    bloop->countof = NULL;
+    switch (limit->tag) {
+    case ULitTag:
+        break;
+    case VarNameUseTag: {
+        VarDclNode *limitvar = (VarDclNode *)((NameUseNode *)limit)->dclnode;
+        if (limitvar->tag != VarDclTag)
+            return 0;
+        if (limitvar->scope == 0 ? permGetFlags(limitvar->perm) & MayWrite : !boundsInvariant(loop, limitvar))
+            return 0;
+        break;
+    }
+    case FnCallTag: {
+        // The count of an unchanging slice
+        if (boundsIntrinsic(limit) != CountIntrinsic)
+            return 0;
+        INode *arr = nodesGet(((FnCallNode *)limit)->args, 0);
+        if (arr->tag == DerefTag)
+            arr = ((DerefNode *)arr)->exp;
+        VarDclNode *arrvar = boundsLocalVar(arr);
+        if (arrvar == NULL || !boundsInvariant(loop, arrvar))
+            return 0;
+        bloop->countof = arrvar;
+        break;
+    }
+    default:
+        return 0;
+    }
+    bloop->loop = loop;
+    bloop->var = var;
+    bloop->limit = limit;
+    return 1;
+}
+
+// Mark an index by the loop's variable as in bounds, or hoist its check
+static void boundsIndex(INode *node, void *ctx) {
+    BoundsLoop *bloop = (BoundsLoop *)ctx;
+    if (node->tag != ArrIndexTag || (node->flags & (FlagInBounds | FlagBoundsHoisted)))
+        return;
+    FnCallNode *index = (FnCallNode *)node;
+    INode *arg = nodesGet(index->args, 0);
+    if (arg->tag == CastTag)
+        arg = ((CastNode *)arg)->exp;
+    if (boundsLocalVar(arg) != bloop->var)
+        return;
+
+    INode *objtype = iexpGetTypeDcl(index->objfn);
+    switch (objtype->tag) {
+    case ArrayTag:
+        if (bloop->limit->tag == ULitTag) {
+            if (((ULitNode *)bloop->limit)->uintlit <= ((ArrayNode *)objtype)->size)
+                node->flags |= FlagInBounds;
+            return;
+        }
+        break;
+    case ArrayRefTag:
+    case ArrayDerefTag: {
+        INode *arr = objtype->tag == ArrayDerefTag ? ((DerefNode *)index->objfn)->exp : index->objfn;
+        VarDclNode *arrvar = boundsLocalVar(arr);
+        if (arrvar == NULL || !boundsInvariant(bloop->loop, arrvar))
+            return;
+        if (arrvar == bloop->countof) {
+            node->flags |= FlagInBounds;
+            return;
+        }
+        break;
+    }
+    default:
+        return;
+    }
+
+    // A loop with hoisted checks is generated twice. Were an enclosing loop also versioned,
+    // the inner loop would be generated four times, and so on, doubling with each level.
+    if (bloop->innerhoist)
+        return;
+    node->flags |= FlagBoundsHoisted;
+    if (bloop->loop->hoisted == NULL)
+        bloop->loop->hoisted = newNodes(4);
+    nodesAdd(&bloop->loop->hoisted, node);
+    bloop->loop->limit = bloop->limit;
+}
+
+// Note a loop that has hoisted checks
+static void boundsInnerHoist(INode *node, void *ctx) {
+    if (node->tag == LoopTag && ((LoopNode *)node)->hoisted)
+        *(int *)ctx = 1;
+}
+
+// Analyze the indexes evaluated in a loop before it changes its index variable
+static void boundsLoop(LoopNode *loop) {
+    BoundsLoop bloop;
+    if (!boundsLoopLimit(loop, &bloop))
+        return;
+    bloop.innerhoist = 0;
+    inodeWalk(loop->blk, boundsInnerHoist, &bloop.innerhoist);
+    Nodes *stmts = ((BlockNode *)loop->blk)->stmts;
+    uint32_t i;
+    for (i = 1; i < stmts->used; ++i) {
+        INode *stmt = nodesGet(stmts, i);
+        if (boundsChanged(stmt, bloop.var))
+            break;
+        inodeWalk(stmt, boundsIndex, &bloop);
+    }
+}
+
+// Mark the array indexes of a type-checked function's loops that need no bounds check
+void boundsFn(FnDclNode *fnnode) {
+    if (fnnode->value == NULL || fnnode->value->tag != BlockTag)
+        return;
+    boundsEscaped = newNodes(4);
+    boundsInPlace = newNodes(4);
+    Nodes *loops = newNodes(4);
+    if (!inodeWalk(fnnode->value, boundsScan, &loops) || loops->used == 0)
+        return;
+
+    // Inner loops first, so an index belongs to the innermost loop that can spare its check.
+    // Only the innermost loops with hoisted checks hoist them, so no loop is versioned twice over.
+    uint32_t i = loops->used;
+    while (i--)
+        boundsLoop((LoopNode *)nodesGet(loops, i));
+}
@@ -0,0 +1,30 @@
+/** The bounds analysis pass, which spares array indexes in loops their bounds checks
+ *
+ * For a loop that begins `while i < limit`, where `i` is an unsigned local
+ * and `limit` does not change within the loop, every `arr[i]` evaluated
+ * before the loop's body changes `i` has an index below `limit`. So:
+ * - If `arr` is a fixed-size array no shorter than a literal `limit`, or a
+ *   slice whose count is `limit`, the index is marked FlagInBounds and
+ *   generation emits no check for it.
+ * - Otherwise, if `arr`'s count does not change within the loop, the index is
+ *   marked FlagBoundsHoisted and added to the loop's `hoisted` list.
+ *   Generation checks `limit <= count` for all of them once, ahead of the loop,
+ *   and runs a copy of the loop without their checks when that holds.
+ *
+ * The analysis abandons a loop when it meets any node it does not know.
+ *
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#ifndef bounds_h
+#define bounds_h
+
+typedef struct FnDclNode FnDclNode;
+
+// Mark the array indexes of a type-checked function's loops that need no bounds check
+void boundsFn(FnDclNode *fnnode);
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "ir.h"
 
+#include <string.h>
 #include <assert.h>
 
 // Deep copy a node
@@ -25,6 +26,7 @@ INode *cloneNode(CloneState *cstate, INode *nodep) {
     case BorrowTag:
         node = cloneBorrowNode(cstate, (BorrowNode *)nodep); break;
     case CastTag:
+    case IsTag:
         node = cloneCastNode(cstate, (CastNode *)nodep); break;
     case DerefTag:
         node = cloneDerefNode(cstate, (DerefNode *)nodep); break;
@@ -65,6 +67,8 @@ INode *cloneNode(CloneState *cstate, INode *nodep) {
         node = cloneFLitNode(cstate, (FLitNode *)nodep); break;
     case StringLitTag:
         node = cloneSLitNode((SLitNode *)nodep); break;
+    case NullTag:
+        node = cloneNullNode(cstate, (NullNode *)nodep); break;
 
     case BreakTag:
         node = cloneBreakNode(cstate, (BreakNode *)nodep); break;
@@ -87,6 +91,8 @@ INode *cloneNode(CloneState *cstate, INode *nodep) {
         node = cloneFnSigNode(cstate, (FnSigNode *)nodep); break;
     case PtrTag:
         node = clonePtrNode(cstate, (PtrNode *)nodep); break;
+    case TTupleTag:
+        node = cloneTTupleNode(cstate, (TTupleNode *)nodep); break;
     case RefTag:
     case ArrayRefTag:
     case VirtRefTag:
@@ -143,10 +149,66 @@ void clonePopState() {
     nametblHookPop();
 }
 
+// The dcl map is a stack of original->clone pairs. Its high-water position is
+// pushed and popped as cloning enters and leaves nested declaration scopes.
+// An open-addressing hash index, keyed on the original node's address, finds
+// a pair's stack position without walking the stack. Index slots are never deleted:
+// a slot is only live if it points below the stack's top to a pair for the same original.
+// An epoch stamp empties the whole index at once whenever the stack is fully popped.
+typedef struct CloneDclSlot {
+    INode *original;    // Key: the original dcl node
+    uint32_t pos;       // Position of the original->clone pair in the stack
+    uint32_t epoch;     // Slot is empty unless this matches the current epoch
+} CloneDclSlot;
+
 CloneDclMap *cloneDclMap = NULL;
 uint32_t cloneDclPos = 0;
 uint32_t cloneDclSize = 0;
 
+CloneDclSlot *cloneDclIndex = NULL;
+uint32_t cloneDclIndexSize = 0;     // Number of index slots (power of 2)
+uint32_t cloneDclIndexUsed = 0;     // Number of index slots filled this epoch
+uint32_t cloneDclEpoch = 1;
+
+// Fibonacci hash of a node's address
+#define cloneDclHash(orig) ((uint32_t)(((uint64_t)(uintptr_t)(orig) * 0x9E3779B97F4A7C15ull) >> 32))
+
+// Find the index slot for orig: either empty or holding orig
+CloneDclSlot *cloneDclFindSlot(INode *orig) {
+    uint32_t mask = cloneDclIndexSize - 1;
+    uint32_t tbli = cloneDclHash(orig) & mask;
+    while (1) {
+        CloneDclSlot *slot = &cloneDclIndex[tbli];
+        if (slot->epoch != cloneDclEpoch || slot->original == orig)
+            return slot;
+        tbli = (tbli + 1) & mask;
+    }
+}
+
+// Return 1 if slot is filled and its pair has not been popped off the stack
+int cloneDclIsLive(CloneDclSlot *slot) {
+    return slot->epoch == cloneDclEpoch && slot->pos < cloneDclPos
+        && cloneDclMap[slot->pos].original == slot->original;
+}
+
+// Double the size of the index (or create it), re-indexing only live pairs
+void cloneDclIndexGrow() {
+    cloneDclIndexSize = cloneDclIndexSize == 0 ? 2048 : cloneDclIndexSize << 1;
+    cloneDclIndex = memAllocBlk(cloneDclIndexSize * sizeof(CloneDclSlot));
+    memset(cloneDclIndex, 0, cloneDclIndexSize * sizeof(CloneDclSlot));
+    cloneDclEpoch = 1;
+    cloneDclIndexUsed = 0;
+    for (uint32_t pos = 0; pos < cloneDclPos; ++pos) {
+        CloneDclSlot *slot = cloneDclFindSlot(cloneDclMap[pos].original);
+        if (slot->epoch != cloneDclEpoch) {
+            slot->epoch = cloneDclEpoch;
+            slot->original = cloneDclMap[pos].original;
+            slot->pos = pos;
+            ++cloneDclIndexUsed;
+        }
+    }
+}
+
 // Preserve high-water position in the dcl stack
 uint32_t cloneDclPush() {
     return cloneDclPos;
@@ -155,6 +217,15 @@ uint32_t cloneDclPush() {
 // Restore high-water position in the dcl stack
 void cloneDclPop(uint32_t pos) {
     cloneDclPos = pos;
+
+    // Once the stack is empty, start a fresh epoch so the index is empty too
+    if (pos == 0 && cloneDclIndexUsed > 0) {
+        cloneDclIndexUsed = 0;
+        if (++cloneDclEpoch == 0) {
+            memset(cloneDclIndex, 0, cloneDclIndexSize * sizeof(CloneDclSlot));
+            cloneDclEpoch = 1;
+        }
+    }
 }
 
 // Remember a mapping of a declaration node between the original and a copy
@@ -171,17 +242,30 @@ void cloneDclSetMap(INode *orig, INode *clone) {
             memcpy(cloneDclMap, oldmap, cloneDclPos * sizeof(CloneDclMap));
         }
     }
-    CloneDclMap *map = &cloneDclMap[cloneDclPos++];
+    uint32_t pos = cloneDclPos++;
+    CloneDclMap *map = &cloneDclMap[pos];
     map->original = orig;
     map->clone = clone;
+
+    // Index the new pair, keeping it at no more than 50% utilization.
+    // If a live pair lower in the stack already maps orig, it takes precedence.
+    if ((cloneDclIndexUsed + 1) << 1 > cloneDclIndexSize)
+        cloneDclIndexGrow();
+    CloneDclSlot *slot = cloneDclFindSlot(orig);
+    if (slot->epoch != cloneDclEpoch) {
+        slot->epoch = cloneDclEpoch;
+        slot->original = orig;
+        slot->pos = pos;
+        ++cloneDclIndexUsed;
+    }
+    else if (!cloneDclIsLive(slot))
+        slot->pos = pos;
 }
 
 // Return the new pointer to the dcl node, given the original pointer
 INode *cloneDclFix(INode *orig) {
-    for (uint32_t pos = 0; pos < cloneDclPos; ++pos) {
-        CloneDclMap *map = &cloneDclMap[pos];
-        if (map->original == orig)
-            return map->clone;
-    }
-    return orig;
-}
\ No newline at end of file
+    if (cloneDclIndexSize == 0)
+        return orig;
+    CloneDclSlot *slot = cloneDclFindSlot(orig);
+    return cloneDclIsLive(slot) ? cloneDclMap[slot->pos].clone : orig;
+}
@@ -146,7 +146,7 @@ void assignSingleFlow(INode *lval, INode **rval) {
         // If this assignment is supposed to return a reference, it cannot
         if (flowAliasGet(0) > 0) {
             RefNode *reftype = (RefNode *)((IExpNode*)*rval)->vtype;
-            if (reftype->tag == RefTag && reftype->region == (INode*)soRegion)
+            if (reftype->tag == RefTag && regionFrees(reftype->region))
                 errorMsgNode((INode*)lval, ErrorMove, "This frees reference. The reference is inaccessible for use.");
         }
     }
@@ -212,6 +212,18 @@ void assignToOneFlow(INode *lval, VTupleNode *rval) {
     assignSingleFlow(lval, rnodesp++);
 }
 
+// Setting a variable whose value was moved out makes it usable again
+void assignReviveFlow(INode *lval) {
+    if (lval->tag == VTupleTag) {
+        INode **nodesp;
+        uint32_t cnt;
+        for (nodesFor(((VTupleNode *)lval)->values, cnt, nodesp))
+            assignReviveFlow(*nodesp);
+    }
+    else if (lval->tag == VarNameUseTag && ((NameUseNode *)lval)->dclnode->tag == VarDclTag)
+        ((VarDclNode *)((NameUseNode *)lval)->dclnode)->flowtempflags &= ~(VarMoved | VarMaybeMoved);
+}
+
 // Perform data flow analysis on assignment node
 // - lval needs to be mutable.
 // - borrowed reference lifetimes must exceed lifetime of lval
@@ -235,4 +247,5 @@ void assignFlow(FlowState *fstate, AssignNode **nodep) {
     }
 
     flowLoadValue(fstate, &node->rval);
+    assignReviveFlow(node->lval);
 }
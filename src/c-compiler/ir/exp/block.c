@@ -192,6 +192,7 @@ void blockFlow(FlowState *fstate, BlockNode **blknode) {
             size_t svAliasPos = flowAliasPushNew(1);
             flowLoadValue(fstate, retexp);
             flowAliasPop(svAliasPos);
+            flowScopeUnmoved(((ReturnNode *)*nodesp)->dealias);
         }
         break;
     }
@@ -199,15 +200,19 @@ void blockFlow(FlowState *fstate, BlockNode **blknode) {
     {
         INode **retexp = &((ReturnNode *)*nodesp)->exp;
         int doalias = flowScopeDealias(svpos, &((ReturnNode *)*nodesp)->dealias, *retexp);
-        if (*retexp != noValue && doalias)
+        if (*retexp != noValue && doalias) {
             flowLoadValue(fstate, retexp);
+            flowScopeUnmoved(((ReturnNode *)*nodesp)->dealias);
+        }
         break;
     }
     case BreakTag: {
         INode **brkexp = &((BreakNode *)*nodesp)->exp;
-        int doalias = flowScopeDealias(svpos, &((ReturnNode *)*nodesp)->dealias, *brkexp);
-        if (*brkexp != noValue && doalias)
+        int doalias = flowScopeDealias(svpos, &((BreakNode *)*nodesp)->dealias, *brkexp);
+        if (*brkexp != noValue && doalias) {
             flowLoadValue(fstate, brkexp);
+            flowScopeUnmoved(((BreakNode *)*nodesp)->dealias);
+        }
         break;
     }
     case ContinueTag:
@@ -215,6 +220,8 @@ void blockFlow(FlowState *fstate, BlockNode **blknode) {
         break;
     }
 
+    flowMoveLastUses(blk, svpos);
+    flowLocalAllocs(blk, svpos);
     --fstate->scope;
     flowScopePop(svpos);
 }
\ No newline at end of file
@@ -39,6 +39,7 @@ INode *cloneFnCallNode(CloneState *cstate, FnCallNode *node) {
     FnCallNode *newnode;
     newnode = memAllocBlk(sizeof(FnCallNode));
     memcpy(newnode, node, sizeof(FnCallNode));
+    newnode->flags &= ~(FlagInBounds | FlagBoundsHoisted);
     newnode->objfn = cloneNode(cstate, node->objfn);
     if (node->args)
         newnode->args = cloneNodes(cstate, node->args);
@@ -479,10 +480,22 @@ void fnCallTypeCheck(TypeCheckState *pstate, FnCallNode **nodep) {
         return;
     }
 
+    // A region's methods have no self: within it, a bare method name calls that method directly.
+    // One that calls itself likely meant the global of the same name, reachable as ::name
+    int inregion = pstate->typenode && pstate->typenode->tag == RegionTag;
+    if (inregion && node->objfn->tag == VarNameUseTag) {
+        NameUseNode *fnname = (NameUseNode*)node->objfn;
+        if (fnname->qualNames == NULL && fnname->dclnode->tag == FnDclTag
+            && ((FnDclNode*)fnname->dclnode)->vtype == (INode*)pstate->fnsig)
+            errorMsgNode(node->objfn, WarnSelfCall, "This calls the region's own %s method. Use ::%s for the global one.",
+                &fnname->namesym->namestr, &fnname->namesym->namestr);
+    }
+
     // If objfn is the name of a method/field, rewrite to: self.method
     if (node->objfn->tag == VarNameUseTag
         && ((NameUseNode*)node->objfn)->dclnode->flags & FlagMethFld
-        && ((NameUseNode*)node->objfn)->qualNames == NULL) {
+        && ((NameUseNode*)node->objfn)->qualNames == NULL
+        && !inregion) {
         // Build a resolved 'self' node
         NameUseNode *selfnode = newNameUseNode(selfName);
         selfnode->tag = VarNameUseTag;
@@ -202,16 +202,51 @@ void ifTypeCheck(TypeCheckState *pstate, IfNode *ifnode, INode *expectType) {
     }
 }
 
+// Does control leave this block only by reaching its end?
+static int ifArmFallsThru(BlockNode *blk) {
+    if (blk->stmts->used == 0)
+        return 1;
+    uint16_t tag = nodesLast(blk->stmts)->tag;
+    return tag != ReturnTag && tag != BreakTag && tag != ContinueTag;
+}
+
 // Perform data flow analysis on an if expression
+// Each arm starts from the moved state its condition leaves. Where the arms meet,
+// a variable moved by some arms and not others may have been moved.
 void ifFlow(FlowState *fstate, IfNode **ifnodep) {
     IfNode *ifnode = *ifnodep;
     INode **nodesp;
     uint32_t cnt;
+    size_t count;
+    char *condmoved = flowMovedMark(&count);  // Moved state after the conditions so far
+    char *joined = NULL;                      // Joined moved state of arms reaching the end
+    int haselse = 0;
     for (nodesFor(ifnode->condblk, cnt, nodesp)) {
-        if (*nodesp != elseCond)
+        flowMovedRestore(condmoved, count);
+        if (*nodesp != elseCond) {
             flowLoadValue(fstate, nodesp);
+            condmoved = flowMovedMark(&count);
+        }
+        else
+            haselse = 1;
         nodesp++; cnt--;
         blockFlow(fstate, (BlockNode**)nodesp);
         flowAliasReset();
+        if (ifArmFallsThru((BlockNode *)*nodesp)) {
+            if (joined)
+                flowMovedJoin(joined, count);
+            else
+                joined = flowMovedMark(&count);
+        }
+    }
+
+    // Without an else, the last condition's failure also reaches the end
+    if (!haselse) {
+        flowMovedRestore(condmoved, count);
+        if (joined)
+            flowMovedJoin(joined, count);
+        else
+            joined = condmoved;
     }
+    flowMovedRestore(joined ? joined : condmoved, count);
 }
\ No newline at end of file
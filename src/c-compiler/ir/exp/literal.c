@@ -92,6 +92,15 @@ NullNode *newNullNode() {
     return node;
 }
 
+// Clone null literal
+INode *cloneNullNode(CloneState *cstate, NullNode *node) {
+    NullNode *newnode;
+    newnode = memAllocBlk(sizeof(NullNode));
+    memcpy(newnode, node, sizeof(NullNode));
+    newnode->vtype = cloneNode(cstate, node->vtype);
+    return (INode *)newnode;
+}
+
 // Create a new string literal node
 SLitNode *newSLitNode(char *str, INode *type) {
     SLitNode *lit;
@@ -55,6 +55,9 @@ void litTypeCheck(TypeCheckState* pstate, IExpNode *node);
 
 NullNode *newNullNode();
 
+// Clone null literal
+INode *cloneNullNode(CloneState *cstate, NullNode *node);
+
 SLitNode *newSLitNode(char *str, INode *type);
 
 // Clone literal
@@ -15,6 +15,8 @@ LoopNode *newLoopNode() {
     node->blk = NULL;
     node->life = NULL;
     node->breaks = newNodes(2);
+    node->hoisted = NULL;
+    node->limit = NULL;
     return node;
 }
 
@@ -27,6 +29,8 @@ INode *cloneLoopNode(CloneState *cstate, LoopNode *node) {
     newnode->breaks = cloneNodes(cstate, node->breaks);
     newnode->life = (LifetimeNode*)cloneNode(cstate, (INode*)node->life);
     newnode->blk = cloneNode(cstate, node->blk);
+    newnode->hoisted = NULL;
+    newnode->limit = NULL;
     cloneDclPop(dclpos);
     return (INode *)newnode;
 }
@@ -141,5 +145,8 @@ void loopTypeCheck(TypeCheckState *pstate, LoopNode *node, INode *expectType) {
 // Perform data flow analysis on a loop expression
 void loopFlow(FlowState *fstate, LoopNode **nodep) {
     LoopNode *node = *nodep;
+    size_t count;
+    char *moved = flowMovedMark(&count);
     blockFlow(fstate, (BlockNode**)&node->blk);
+    flowMovedInLoop(node, moved, count);
 }
@@ -14,6 +14,8 @@ typedef struct LoopNode {
     INode *blk;
     LifetimeNode *life;   // nullable
     Nodes *breaks;
+    Nodes *hoisted;       // Indexes whose bounds checks are hoisted ahead of the loop (or NULL)
+    INode *limit;         // With hoisted: the value all their indexes are below
 } LoopNode;
 
 LoopNode *newLoopNode();
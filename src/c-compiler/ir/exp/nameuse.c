@@ -43,6 +43,18 @@ INode *cloneNameUseNode(CloneState *cstate, NameUseNode *node) {
     newnode = memAllocBlk(sizeof(NameUseNode));
     memcpy(newnode, node, sizeof(NameUseNode));
     newnode->dclnode = cloneDclFix(node->dclnode);
+
+    // Module qualifiers relative to a module that has been mapped to another one
+    // (see parseInclude) must now start from that other module
+    if (node->qualNames) {
+        ModuleNode *basemod = (ModuleNode*)cloneDclFix((INode*)node->qualNames->basemod);
+        if (basemod != node->qualNames->basemod) {
+            size_t listsize = sizeof(NameList) + node->qualNames->avail * sizeof(Name*);
+            newnode->qualNames = (NameList *)memAllocBlk(listsize);
+            memcpy(newnode->qualNames, node->qualNames, listsize);
+            newnode->qualNames->basemod = basemod;
+        }
+    }
     return (INode *)newnode;
 }
 
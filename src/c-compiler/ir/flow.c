@@ -10,10 +10,49 @@
 #include <assert.h>
 #include <memory.h>
 
+// Return the local variable an lval expression reaches into (or NULL)
+static VarDclNode *flowLvalVar(INode *node) {
+    while (1) {
+        switch (node->tag) {
+        case VarNameUseTag: {
+            VarDclNode *var = (VarDclNode *)((NameUseNode *)node)->dclnode;
+            return var->tag == VarDclTag && var->scope > 0 ? var : NULL;
+        }
+        case FldAccessTag:
+        case ArrIndexTag:
+            node = ((FnCallNode *)node)->objfn;
+            break;
+        case DerefTag:
+            node = ((DerefNode *)node)->exp;
+            break;
+        default:
+            return NULL;
+        }
+    }
+}
+
+// A value may not be used once it has been moved out of its variable
+void flowUseVar(INode *node) {
+    VarDclNode *var = flowLvalVar(node);
+    if (var && (var->flowtempflags & VarMoved))
+        errorMsgNode(node, ErrorMove, "%s was moved, so it cannot be used until it is set again.", &var->namesym->namestr);
+    else if (var && (var->flowtempflags & VarMaybeMoved))
+        errorMsgNode(node, ErrorMove, "%s may have been moved, so it cannot be used until it is set again.", &var->namesym->namestr);
+}
+
+// Copying a value whose type has move semantics moves it instead.
+// The variable moved from gives up its value: it is unusable until set again, and it is not dropped.
 void flowHandleMove(INode *node) {
     uint16_t moveflag = itypeGetTypeDcl(((IExpNode *)node)->vtype)->flags & MoveType;
-    if (moveflag)
-        errorMsgNode(node, WarnCopy, "No current support for move. Be sure this is safe!");
+    if (!moveflag)
+        return;
+    VarDclNode *var = node->tag == VarNameUseTag ? flowLvalVar(node) : NULL;
+    if (var == NULL) {
+        errorMsgNode(node, WarnCopy, "Only a local variable's value can be moved. Be sure this copy is safe!");
+        return;
+    }
+    var->flowtempflags |= VarMoved;
+    node->flags |= FlagMoveOut;
 }
 
 // If needed, inject an alias node for rc/own references
@@ -24,10 +63,13 @@ void flowInjectAliasNode(INode **nodep, int16_t rvalcount) {
     if (vtype->tag != TTupleTag) {
         // No need for injected node if we are not dealing with rc/own references and if alias calc = 0
         RefNode *reftype = (RefNode *)itypeGetTypeDcl(vtype);
-        if (reftype->tag != RefTag || !(reftype->region == (INode*)rcRegion || reftype->region == (INode*)soRegion))
+        if (reftype->tag != RefTag || !(regionCounts(reftype->region) || regionFrees(reftype->region)))
             return;
         count = flowAliasGet(0) + rvalcount;
-        if (count == 0 || (reftype->region == (INode*)soRegion && count > 0))
+        if (count == 0 || (!regionCounts(reftype->region) && count > 0))
+            return;
+        // An rc value moved out of its variable takes the variable's count with it
+        if (count > 0 && (*nodep)->tag == VarNameUseTag && ((*nodep)->flags & FlagMoveOut))
             return;
     }
     else {
@@ -42,12 +84,12 @@ void flowInjectAliasNode(INode **nodep, int16_t rvalcount) {
         flowAliasSize(count = tuple->types->used);
         for (nodesFor(tuple->types, cnt, nodesp)) {
             RefNode *reftype = (RefNode *)itypeGetTypeDcl(*nodesp);
-            if (reftype->tag != RefTag || !(reftype->region == (INode*)rcRegion || reftype->region == (INode*)soRegion)) {
+            if (reftype->tag != RefTag || !(regionCounts(reftype->region) || regionFrees(reftype->region))) {
                 flowAliasPut(index++, 0);
                 continue;
             }
             int16_t tcount = flowAliasGet(index) + rvalcount;
-            if (reftype->region == (INode*)soRegion && tcount > 0)
+            if (!regionCounts(reftype->region) && tcount > 0)
                 tcount = 0;
             flowAliasPut(index++, tcount);
             if (tcount != 0)
@@ -117,10 +159,10 @@ void flowLoadValue(FlowState *fstate, INode **nodep) {
     case DerefTag:
     case ArrIndexTag:
     case FldAccessTag:
-        flowInjectAliasNode(nodep, 0);
-        if (flowAliasGet(0) > 0) {
+        flowUseVar(*nodep);
+        if (flowAliasGet(0) > 0)
             flowHandleMove(*nodep);
-        }
+        flowInjectAliasNode(nodep, 0);
         break;
     case CastTag: case IsTag:
         flowLoadValue(fstate, &((CastNode *)*nodep)->exp);
@@ -130,9 +172,14 @@ void flowLoadValue(FlowState *fstate, INode **nodep) {
         break;
     case OrLogicTag: case AndLogicTag:
     {
+        // The right side may not be evaluated, so any move in it may not happen
         LogicNode *lnode = (LogicNode*)*nodep;
         flowLoadValue(fstate, &lnode->lexp);
+        size_t count;
+        char *moved = flowMovedMark(&count);
         flowLoadValue(fstate, &lnode->rexp);
+        flowMovedJoin(moved, count);
+        flowMovedRestore(moved, count);
         break;
     }
 
@@ -173,7 +220,7 @@ void flowAddVar(VarDclNode *varnode) {
     if (gVarFlowStackPos >= gVarFlowStackSz) {
         if (gVarFlowStackSz == 0) {
             gVarFlowStackSz = 1024;
-            gVarFlowStackp = (VarFlowInfo*)memAllocBlk(gVarFlowStackSz * sizeof(VarFlowInfo));
+            gVarFlowStackp = (VarFlowInfo*)memAllocTmp(gVarFlowStackSz * sizeof(VarFlowInfo));
             memset(gVarFlowStackp, 0, gVarFlowStackSz * sizeof(VarFlowInfo));
             gVarFlowStackPos = 0;
         }
@@ -182,7 +229,7 @@ void flowAddVar(VarDclNode *varnode) {
             VarFlowInfo *oldtable = gVarFlowStackp;
             int oldsize = gVarFlowStackSz;
             gVarFlowStackSz <<= 1;
-            gVarFlowStackp = (VarFlowInfo*)memAllocBlk(gVarFlowStackSz * sizeof(VarFlowInfo));
+            gVarFlowStackp = (VarFlowInfo*)memAllocTmp(gVarFlowStackSz * sizeof(VarFlowInfo));
             memset(gVarFlowStackp, 0, gVarFlowStackSz * sizeof(VarFlowInfo));
             memcpy(gVarFlowStackp, oldtable, oldsize * sizeof(VarFlowInfo));
         }
@@ -190,6 +237,7 @@ void flowAddVar(VarDclNode *varnode) {
     VarFlowInfo *stackp = &gVarFlowStackp[gVarFlowStackPos++];
     stackp->node = varnode;
     stackp->flags = 0;
+    varnode->flowtempflags &= ~(VarMoved | VarMaybeMoved);
 }
 
 // Start a new scope
@@ -198,6 +246,7 @@ size_t flowScopePush() {
 }
 
 // Create de-alias list of all own/rc reference variables (except single retexp name)
+// A variable moved on some paths only is dropped if its drop flag says it still has its value.
 // As a simple optimization: returns 0 if retexp name was not de-aliased
 int flowScopeDealias(size_t startpos, Nodes **varlist, INode *retexp) {
     int doalias = 1;
@@ -205,7 +254,11 @@ int flowScopeDealias(size_t startpos, Nodes **varlist, INode *retexp) {
     while (pos > startpos) {
         VarFlowInfo *avar = &gVarFlowStackp[--pos];
         RefNode *reftype = (RefNode*)avar->node->vtype;
-        if (reftype->tag == RefTag && (reftype->region == (INode*)rcRegion || reftype->region == (INode*)soRegion)) {
+        if (avar->node->flowtempflags & VarMoved)
+            continue;
+        if (avar->node->flowtempflags & VarMaybeMoved)
+            avar->node->flowflags |= VarDropFlag;
+        if (reftype->tag == RefTag && (regionCounts(reftype->region) || regionFrees(reftype->region))) {
             if (retexp->tag != VarNameUseTag || ((NameUseNode *)retexp)->namesym != avar->node->namesym) {
                 if (*varlist == NULL)
                     *varlist = newNodes(4);
@@ -223,6 +276,284 @@ void flowScopePop(size_t startpos) {
     gVarFlowStackPos = startpos;
 }
 
+// Take variables moved from since a dealias list was made back off it.
+// An exit's value may move a variable that the exit would otherwise drop.
+void flowScopeUnmoved(Nodes *varlist) {
+    if (varlist == NULL)
+        return;
+    uint32_t i = 0;
+    while (i < varlist->used) {
+        VarDclNode *var = (VarDclNode *)nodesGet(varlist, i);
+        if (var->flowtempflags & VarMoved) {
+            memmove(&nodesGet(varlist, i), &nodesGet(varlist, i + 1), (varlist->used - i - 1) * sizeof(INode *));
+            --varlist->used;
+        }
+        else {
+            if (var->flowtempflags & VarMaybeMoved)
+                var->flowflags |= VarDropFlag;
+            ++i;
+        }
+    }
+}
+
+// Snapshot which variables now in scope have been moved from (in temporary memory)
+char *flowMovedMark(size_t *countp) {
+    char *moved = (char *)memAllocTmp(gVarFlowStackPos + 1);
+    size_t pos;
+    for (pos = 0; pos < gVarFlowStackPos; ++pos)
+        moved[pos] = (char)(gVarFlowStackp[pos].node->flowtempflags & (VarMoved | VarMaybeMoved));
+    *countp = gVarFlowStackPos;
+    return moved;
+}
+
+// Put back the moved state of a snapshot's variables
+void flowMovedRestore(char *moved, size_t count) {
+    size_t pos;
+    for (pos = 0; pos < count; ++pos) {
+        VarDclNode *var = gVarFlowStackp[pos].node;
+        var->flowtempflags = (var->flowtempflags & ~(VarMoved | VarMaybeMoved)) | moved[pos];
+    }
+}
+
+// Join the moved state of another path into a snapshot, where two paths meet.
+// A variable moved on one path but not the other may have been moved.
+void flowMovedJoin(char *moved, size_t count) {
+    size_t pos;
+    for (pos = 0; pos < count; ++pos) {
+        char state = (char)(gVarFlowStackp[pos].node->flowtempflags & (VarMoved | VarMaybeMoved));
+        if (state != moved[pos])
+            moved[pos] = VarMaybeMoved;
+    }
+}
+
+// A loop must not move from a variable declared outside it,
+// as the loop's next iteration would use or move it again
+void flowMovedInLoop(LoopNode *loop, char *moved, size_t count) {
+    size_t pos;
+    for (pos = 0; pos < count; ++pos) {
+        VarDclNode *var = gVarFlowStackp[pos].node;
+        if ((var->flowtempflags & (VarMoved | VarMaybeMoved)) && !moved[pos])
+            errorMsgNode((INode *)loop, ErrorMove, "This loop moves %s, which its next iteration would use again.", &var->namesym->namestr);
+    }
+}
+
+// *********************
+// Last-use moves of rc references
+//
+// Copying an rc reference out of a variable increments its count, and the variable
+// decrements it when its scope ends. When that copy is the variable's last use, and
+// is sure to happen, the copy takes over the variable's count instead: both the
+// increment and the decrement are dropped.
+// *********************
+
+// What flowMentions looks for in a statement
+typedef struct {
+    VarDclNode *var;
+    int mentions;    // Number of uses of var
+    int borrowed;    // Whether var (or something inside its value) is borrowed
+    int exits;       // Number of return, break and continue nodes
+} FlowMention;
+
+static void flowMentions(INode *node, void *ctx) {
+    FlowMention *mention = (FlowMention *)ctx;
+    switch (node->tag) {
+    case VarNameUseTag:
+        if (((NameUseNode *)node)->dclnode == (INode *)mention->var)
+            ++mention->mentions;
+        break;
+    case BorrowTag:
+        if (flowLvalVar(((BorrowNode *)node)->exp) == mention->var)
+            mention->borrowed = 1;
+        break;
+    case ReturnTag:
+    case BreakTag:
+    case ContinueTag:
+        ++mention->exits;
+        break;
+    }
+}
+
+// Find the alias node copying var's value where it is always evaluated within a statement
+static INode **flowFindAlias(INode **nodep, VarDclNode *var) {
+    INode *node = *nodep;
+    INode **found = NULL;
+    switch (node->tag) {
+    case AliasTag: {
+        AliasNode *alias = (AliasNode *)node;
+        if (alias->counts == NULL && alias->aliasamt > 0 && alias->exp->tag == VarNameUseTag
+            && ((NameUseNode *)alias->exp)->dclnode == (INode *)var)
+            return nodep;
+        return flowFindAlias(&alias->exp, var);
+    }
+    case VarDclTag:
+        return ((VarDclNode *)node)->value ? flowFindAlias(&((VarDclNode *)node)->value, var) : NULL;
+    case AssignTag:
+        return flowFindAlias(&((AssignNode *)node)->rval, var);
+    case FnCallTag:
+    case ArrIndexTag:
+    case FldAccessTag: {
+        FnCallNode *fncall = (FnCallNode *)node;
+        if ((found = flowFindAlias(&fncall->objfn, var)) || fncall->args == NULL)
+            return found;
+        INode **nodesp;
+        uint32_t cnt;
+        for (nodesFor(fncall->args, cnt, nodesp)) {
+            if ((found = flowFindAlias(nodesp, var)))
+                return found;
+        }
+        return NULL;
+    }
+    case VTupleTag: {
+        INode **nodesp;
+        uint32_t cnt;
+        for (nodesFor(((VTupleNode *)node)->values, cnt, nodesp)) {
+            if ((found = flowFindAlias(nodesp, var)))
+                return found;
+        }
+        return NULL;
+    }
+    case CastTag:
+    case IsTag:
+        return flowFindAlias(&((CastNode *)node)->exp, var);
+    case DerefTag:
+        return flowFindAlias(&((DerefNode *)node)->exp, var);
+    case NotLogicTag:
+    case OrLogicTag:    // Only the left side is always evaluated
+    case AndLogicTag:
+        return flowFindAlias(&((LogicNode *)node)->lexp, var);
+    case ReturnTag:
+    case BlockRetTag:
+        return flowFindAlias(&((ReturnNode *)node)->exp, var);
+    case BreakTag:
+        return flowFindAlias(&((BreakNode *)node)->exp, var);
+    default:
+        return NULL;
+    }
+}
+
+// Remove a variable from a dealias list
+static void flowUndealias(Nodes *dealias, VarDclNode *var) {
+    if (dealias == NULL)
+        return;
+    uint32_t i;
+    for (i = 0; i < dealias->used; ++i) {
+        if (nodesGet(dealias, i) == (INode *)var) {
+            memmove(&nodesGet(dealias, i), &nodesGet(dealias, i + 1), (dealias->used - i - 1) * sizeof(INode *));
+            --dealias->used;
+            return;
+        }
+    }
+}
+
+// Stop an exit node from dropping the variable
+static void flowUndealiasExit(INode *node, void *ctx) {
+    switch (node->tag) {
+    case ReturnTag:
+    case BlockRetTag:
+        flowUndealias(((ReturnNode *)node)->dealias, (VarDclNode *)ctx);
+        break;
+    case BreakTag:
+        flowUndealias(((BreakNode *)node)->dealias, (VarDclNode *)ctx);
+        break;
+    case ContinueTag:
+        flowUndealias(((ContinueNode *)node)->dealias, (VarDclNode *)ctx);
+        break;
+    }
+}
+
+// Move an rc variable's reference into its last use, if that is an unconditional copy
+static void flowMoveLastUse(BlockNode *blk, VarDclNode *var) {
+    Nodes *stmts = blk->stmts;
+    FlowMention mention;
+    FlowMention lastmention;
+    uint32_t last = stmts->used;
+    uint32_t i;
+    for (i = 0; i < stmts->used; ++i) {
+        mention.var = var;
+        mention.mentions = mention.borrowed = mention.exits = 0;
+        if (!inodeWalk(nodesGet(stmts, i), flowMentions, &mention) || mention.borrowed)
+            return;
+        if (mention.mentions) {
+            last = i;
+            lastmention = mention;
+        }
+    }
+    if (last == stmts->used || lastmention.mentions != 1)
+        return;
+
+    // The copy must come before any exit from within its statement
+    INode **stmtp = &nodesGet(stmts, last);
+    int isexit = (*stmtp)->tag == ReturnTag || (*stmtp)->tag == BreakTag || (*stmtp)->tag == ContinueTag;
+    if (lastmention.exits > isexit)
+        return;
+    INode **aliasp = flowFindAlias(stmtp, var);
+    if (aliasp == NULL)
+        return;
+
+    AliasNode *alias = (AliasNode *)*aliasp;
+    if (--alias->aliasamt == 0)
+        *aliasp = alias->exp;
+    for (i = last; i < stmts->used; ++i)
+        inodeWalk(nodesGet(stmts, i), flowUndealiasExit, var);
+}
+
+// Give the rc variables declared in a block's scope over to their last uses, where possible
+void flowMoveLastUses(BlockNode *blk, size_t startpos) {
+    size_t pos;
+    for (pos = startpos; pos < gVarFlowStackPos; ++pos) {
+        VarDclNode *var = gVarFlowStackp[pos].node;
+        RefNode *reftype = (RefNode *)var->vtype;
+        if (reftype->tag == RefTag && regionCounts(reftype->region)
+            && !(reftype->flags & MoveType) && !(var->flowtempflags & VarMoved))
+            flowMoveLastUse(blk, var);
+    }
+}
+
+// *********************
+// Escape analysis of own allocations
+//
+// A variable initialized with a newly allocated own reference frees that allocation
+// when its scope ends. If the variable is only ever dereferenced, the reference
+// never leaves the function, so its value can live in the function's stack frame.
+// Generation puts it there only if the value is small (see genlStackAlloc).
+// *********************
+
+// What flowDerefs counts in a block
+typedef struct {
+    VarDclNode *var;
+    int mentions;    // Number of uses of var
+    int derefs;      // Number of those that dereference it
+} FlowDeref;
+
+static void flowDerefs(INode *node, void *ctx) {
+    FlowDeref *deref = (FlowDeref *)ctx;
+    if (node->tag == VarNameUseTag && ((NameUseNode *)node)->dclnode == (INode *)deref->var)
+        ++deref->mentions;
+    else if (node->tag == DerefTag) {
+        INode *exp = ((DerefNode *)node)->exp;
+        if (exp->tag == VarNameUseTag && ((NameUseNode *)exp)->dclnode == (INode *)deref->var)
+            ++deref->derefs;
+    }
+}
+
+// Mark the own allocations of a block's variables that do not escape.
+// A declared region's allocations are left alone, as its alloc and free may do more than allocate.
+void flowLocalAllocs(BlockNode *blk, size_t startpos) {
+    size_t pos;
+    for (pos = startpos; pos < gVarFlowStackPos; ++pos) {
+        VarDclNode *var = gVarFlowStackp[pos].node;
+        RefNode *reftype = (RefNode *)var->vtype;
+        if (reftype->tag != RefTag || !(reftype->region == (INode*)soRegion || reftype->region == (INode*)poolRegion)
+            || var->value == NULL || var->value->tag != AllocateTag || (var->flowtempflags & (VarMoved | VarMaybeMoved)))
+            continue;
+        FlowDeref deref;
+        deref.var = var;
+        deref.mentions = deref.derefs = 0;
+        if (inodeWalk((INode *)blk, flowDerefs, &deref) && deref.mentions == deref.derefs)
+            var->value->flags |= FlagStackAlloc;
+    }
+}
+
 // *********************
 // Aliasing stack for data flow analysis
 //
@@ -240,7 +571,7 @@ void flowAliasRoom(size_t highpos) {
     if (highpos >= gFlowAliasStackSz) {
         if (gFlowAliasStackSz == 0) {
             gFlowAliasStackSz = 1024;
-            gFlowAliasStackp = (int16_t*)memAllocBlk(gFlowAliasStackSz * sizeof(int16_t));
+            gFlowAliasStackp = (int16_t*)memAllocTmp(gFlowAliasStackSz * sizeof(int16_t));
             memset(gFlowAliasStackp, 0, gFlowAliasStackSz * sizeof(int16_t));
             gFlowAliasStackPos = 0;
         }
@@ -249,13 +580,26 @@ void flowAliasRoom(size_t highpos) {
             int16_t *oldtable = gFlowAliasStackp;
             int oldsize = gFlowAliasStackSz;
             gFlowAliasStackSz <<= 1;
-            gFlowAliasStackp = (int16_t*)memAllocBlk(gFlowAliasStackSz * sizeof(int16_t));
+            gFlowAliasStackp = (int16_t*)memAllocTmp(gFlowAliasStackSz * sizeof(int16_t));
             memset(gFlowAliasStackp, 0, gFlowAliasStackSz * sizeof(int16_t));
             memcpy(gFlowAliasStackp, oldtable, oldsize * sizeof(int16_t));
         }
     }
 }
 
+// Initialize a function's flow stacks
+// They live in the temporary arena, which the caller releases once the function is analyzed
+void flowInit() {
+    gVarFlowStackp = NULL;
+    gVarFlowStackSz = 0;
+    gVarFlowStackPos = 0;
+    gFlowAliasStackp = NULL;
+    gFlowAliasStackSz = 0;
+    gFlowAliasStackPos = 0;
+    gFlowAliasFocusPos = 0;
+    flowAliasInit();
+}
+
 // Initialize a function's alias stack
 void flowAliasInit() {
     flowAliasRoom(3);
@@ -21,6 +21,8 @@
 
 typedef struct VarDclNode VarDclNode;
 typedef struct FnSigNode FnSigNode;
+typedef struct LoopNode LoopNode;
+typedef struct BlockNode BlockNode;
 
 // Context used across the data flow pass for a specific function/method
 typedef struct FlowState {
@@ -34,6 +36,9 @@ typedef struct FlowState {
 // If copied, we may need to alias it. If moved, we may have to deactivate its source.
 void flowLoadValue(FlowState *fstate, INode **nodep);
 
+// Initialize a function's flow stacks (allocated in the temporary arena)
+void flowInit();
+
 // Add a just declared variable to the data flow stack
 void flowAddVar(VarDclNode *varnode);
 
@@ -45,6 +50,23 @@ size_t flowScopePush();
 int flowScopeDealias(size_t pos, Nodes **varlist, INode *retexp);
 // Back out of current scope
 void flowScopePop(size_t pos);
+// Take variables moved from since a dealias list was made back off it
+void flowScopeUnmoved(Nodes *varlist);
+
+// A value may not be used once it has been moved out of its variable
+void flowUseVar(INode *node);
+// Snapshot which variables now in scope have been moved from (in temporary memory)
+char *flowMovedMark(size_t *countp);
+// Put back the moved state of a snapshot's variables
+void flowMovedRestore(char *moved, size_t count);
+// Join the moved state of another path into a snapshot, where two paths meet
+void flowMovedJoin(char *moved, size_t count);
+// A loop must not move from a variable declared outside it
+void flowMovedInLoop(LoopNode *loop, char *moved, size_t count);
+// Give the rc variables declared in a block's scope over to their last uses, where possible
+void flowMoveLastUses(BlockNode *blk, size_t startpos);
+// Mark the own allocations of a block's variables that do not escape
+void flowLocalAllocs(BlockNode *blk, size_t startpos);
 
 // Alias Node structure
 typedef struct {
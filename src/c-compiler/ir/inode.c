@@ -17,10 +17,7 @@
 
 // Copy lexer info over
 void inodeLexCopy(INode *new, INode *old) {
-    new->lexer = old->lexer;
-    new->linenbr = old->linenbr;
-    new->linep = old->linep;
-    new->srcp = old->srcp;
+    new->srcloc = old->srcloc;
 }
 
 // State for inodePrint
@@ -183,7 +180,7 @@ void inodePrintNode(INode *node) {
 
 // Serialize the program's IR to dir+srcfn
 void inodePrint(char *dir, char *srcfn, INode *pgmnode) {
-    irfile = fopen(fileMakePath(dir, pgmnode->lexer->fname, "ast"), "wb");
+    irfile = fopen(fileMakePath(dir, lexSrcFile(pgmnode->srcloc)->fname, "ast"), "wb");
     inodePrintNode(pgmnode);
     fclose(irfile);
 }
@@ -424,3 +421,81 @@ void inodeTypeCheck(TypeCheckState *pstate, INode **node, INode *expectType) {
 void inodeTypeCheckAny(TypeCheckState *pstate, INode **pgm) {
     inodeTypeCheck(pstate, pgm, unknownType);
 }
+
+// Walk every node in a list
+static int inodeWalkNodes(Nodes *nodes, INodeVisitFn visit, void *ctx) {
+    uint32_t cnt;
+    INode **nodesp;
+    for (nodesFor(nodes, cnt, nodesp)) {
+        if (!inodeWalk(*nodesp, visit, ctx))
+            return 0;
+    }
+    return 1;
+}
+
+// Visit every node of a type-checked statement or expression tree, parents before children.
+// Returns 0 if the tree holds a node the walk does not know.
+int inodeWalk(INode *node, INodeVisitFn visit, void *ctx) {
+    if (node == NULL)
+        return 1;
+    visit(node, ctx);
+    switch (node->tag) {
+    case VarNameUseTag:
+    case MbrNameUseTag:
+    case ULitTag:
+    case FLitTag:
+    case NullTag:
+    case StringLitTag:
+    case SizeofTag:
+    case ContinueTag:
+    case AbsenceTag:
+        return 1;
+    case VarDclTag:
+        return inodeWalk(((VarDclNode *)node)->value, visit, ctx);
+    case AssignTag:
+        return inodeWalk(((AssignNode *)node)->lval, visit, ctx)
+            && inodeWalk(((AssignNode *)node)->rval, visit, ctx);
+    case FnCallTag:
+    case ArrIndexTag:
+    case FldAccessTag:
+        if (!inodeWalk(((FnCallNode *)node)->objfn, visit, ctx))
+            return 0;
+        // fallthrough
+    case TypeLitTag:
+        return ((FnCallNode *)node)->args == NULL || inodeWalkNodes(((FnCallNode *)node)->args, visit, ctx);
+    case CastTag:
+    case IsTag:
+        return inodeWalk(((CastNode *)node)->exp, visit, ctx);
+    case BorrowTag:
+        return inodeWalk(((BorrowNode *)node)->exp, visit, ctx);
+    case AllocateTag:
+        return inodeWalk(((AllocateNode *)node)->exp, visit, ctx);
+    case DerefTag:
+        return inodeWalk(((DerefNode *)node)->exp, visit, ctx);
+    case AliasTag:
+        return inodeWalk(((AliasNode *)node)->exp, visit, ctx);
+    case NotLogicTag:
+        return inodeWalk(((LogicNode *)node)->lexp, visit, ctx);
+    case OrLogicTag:
+    case AndLogicTag:
+        return inodeWalk(((LogicNode *)node)->lexp, visit, ctx)
+            && inodeWalk(((LogicNode *)node)->rexp, visit, ctx);
+    case NamedValTag:
+        return inodeWalk(((NamedValNode *)node)->val, visit, ctx);
+    case VTupleTag:
+        return inodeWalkNodes(((VTupleNode *)node)->values, visit, ctx);
+    case BlockTag:
+        return inodeWalkNodes(((BlockNode *)node)->stmts, visit, ctx);
+    case IfTag:
+        return inodeWalkNodes(((IfNode *)node)->condblk, visit, ctx);
+    case LoopTag:
+        return inodeWalk(((LoopNode *)node)->blk, visit, ctx);
+    case ReturnTag:
+    case BlockRetTag:
+        return inodeWalk(((ReturnNode *)node)->exp, visit, ctx);
+    case BreakTag:
+        return inodeWalk(((BreakNode *)node)->exp, visit, ctx);
+    default:
+        return 0;
+    }
+}
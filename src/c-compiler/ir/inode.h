@@ -20,21 +20,16 @@
 
 #include "memory.h"
 
-// All IR nodes begin with this header, mostly containing lexer data describing
-// where in the source this structure came from (useful for error messages)
+// All IR nodes begin with this header, describing what the node is
+// and where in the source this structure came from (useful for error messages)
 // - tag contains the NodeTags code
 // - flags contains node-specific flags
 // - instnode points to what triggered instancing, if not NULL
-// - lexer contains -> url (filepath) and -> source
-// - srcp points to start of source token
-// - linep points to start of line that token begins on
-// - linenbr is the source file's line number, starting with 1
+// - srcloc is where the node's source token starts. lexSrcPos expands it
+//   into the source file (url, source), line number and token/line position.
 #define INodeHdr \
     INode *instnode; \
-    Lexer *lexer; \
-    char *srcp; \
-    char *linep; \
-    uint32_t linenbr; \
+    uint32_t srcloc; \
     uint16_t tag; \
     uint16_t flags
 
@@ -163,9 +158,15 @@ enum NodeTags {
 #define FlagVDisp     0x0004        // FnCall: a virtual dispatch function call
 #define FlagLvalOp    0x0008        // FnCall: op requires an lval as object (a mutable ref)
 #define FlagOpAssgn   0x0010        // FnCall: method is an operator assignment (e.g., +=)
+#define FlagInBounds  0x0020        // ArrIndex: index is proven within bounds (no check)
+#define FlagBoundsHoisted 0x0040    // ArrIndex: bounds check is hoisted ahead of its loop
 
 #define FlagSuffix    0x0001        // Borrow: part of a borrow chain
 
+#define FlagMoveOut   0x0001        // VarNameUse: moves the value out of its variable
+
+#define FlagStackAlloc 0x0001       // Allocate: own reference does not escape, so a small value is on the stack
+
 // Flags used across all types
 #define MoveType           0x0001  // Type's values impose move semantics (vs. copy)
 #define ThreadBound        0x0002  // Type's value copies must stay in the same thread (vs. sendable)
@@ -175,6 +176,9 @@ enum NodeTags {
 #define SameSize           0x0010  // An enumtrait, where all implementations are padded to same size
 #define HasTagField        0x0020  // A trait/struct has an enumerated field identifying the variant type
 #define NullablePtr        0x0040  // trait/struct has nullable pointer, generating optimized data
+#define InternedType       0x0080  // Structural type is the one interned instance of its kind
+#define CountedRegion      0x0100  // A declared region whose references are reference counted, as with rc
+#define InternedUse        0x0200  // Structural type use whose interned instance is another node
 
 #define TypeChecked        0x8000  // Type has been type-checked
 #define TypeChecking       0x4000  // Type is in process of being type-checked
@@ -185,18 +189,12 @@ enum NodeTags {
     node->tag = nodetype; \
     node->flags = 0; \
     node->instnode = NULL; \
-    node->lexer = lex; \
-    node->srcp = lex->tokp; \
-    node->linep = lex->linep; \
-    node->linenbr = lex->linenbr; \
+    node->srcloc = lexTokSrcloc(); \
 }
 
 // Copy lexer info over to another node
 #define copyNodeLex(newnode, oldnode) { \
-    (newnode)->lexer = (oldnode)->lexer; \
-    (newnode)->srcp = (oldnode)->srcp; \
-    (newnode)->linep = (oldnode)->linep; \
-    (newnode)->linenbr = (oldnode)->linenbr; \
+    (newnode)->srcloc = (oldnode)->srcloc; \
 }
 
 // Copy lexer info over
@@ -228,4 +226,11 @@ void inodeTypeCheck(TypeCheckState *pstate, INode **pgm, INode *expectType);
 // - node is a pointer to pointer so that a node can be replaced
 void inodeTypeCheckAny(TypeCheckState *pstate, INode **pgm);
 
+// Called by inodeWalk on each node it visits
+typedef void (*INodeVisitFn)(INode *node, void *ctx);
+
+// Visit every node of a type-checked statement or expression tree, parents before children.
+// Returns 0 if the tree holds a node the walk does not know.
+int inodeWalk(INode *node, INodeVisitFn visit, void *ctx);
+
 #endif
\ No newline at end of file
@@ -45,6 +45,7 @@ typedef struct TypeCheckState TypeCheckState;
 #include "instype.h"
 #include "clone.h"
 #include "flow.h"
+#include "bounds.h"
 
 // These includes are needed by all node handling
 #include "../parser/lexer.h"
@@ -65,9 +66,7 @@ typedef struct TypeCheckState TypeCheckState;
 #include "types/struct.h"
 #include "types/array.h"
 #include "types/void.h"
-typedef struct AllocNode {
-    INsTypeNodeHdr;
-} AllocNode;
+#include "types/region.h"
 
 #include "stmt/module.h"
 #include "stmt/break.h"
@@ -10,6 +10,20 @@
 #include <string.h>
 #include <assert.h>
 
+// Where a structural type's node points at its interned instance (see InternedUse)
+static INode **itypeInternedp(INode *type) {
+    switch (type->tag) {
+    case PtrTag:
+        return &((PtrNode*)type)->interned;
+    case ArrayTag:
+        return &((ArrayNode*)type)->interned;
+    case TTupleTag:
+        return &((TTupleNode*)type)->interned;
+    default:
+        return &((RefNode*)type)->interned;
+    }
+}
+
 // Return node's type's declaration node
 // (Note: only use after it has been type-checked)
 INode *itypeGetTypeDcl(INode *type) {
@@ -21,7 +35,7 @@ INode *itypeGetTypeDcl(INode *type) {
         case TypedefTag:
             type = ((TypedefNode *)type)->typeval;
         default:
-            return type;
+            return (type->flags & InternedUse) ? *itypeInternedp(type) : type;
         }
     }
 }
@@ -43,6 +57,7 @@ int itypeTypeCheck(TypeCheckState *pstate, INode **node) {
         errorMsgNode(*node, ErrorNotTyped, "Expected a type.");
         return 0;
     }
+    itypeIntern(*node);
     return 1;
 }
 
@@ -59,6 +74,10 @@ int itypeIsSame(INode *node1, INode *node2) {
     if (node1->tag != node2->tag)
         return 0;
 
+    // Two different interned types can never be structurally the same
+    if (node1->flags & node2->flags & InternedType)
+        return 0;
+
     // For non-named types, equality is determined structurally
     // because they specify the same typed parts
     switch (node1->tag) {
@@ -74,6 +93,8 @@ int itypeIsSame(INode *node1, INode *node2) {
         return ptrEqual((PtrNode*)node1, (PtrNode*)node2);
     case ArrayTag:
         return arrayEqual((ArrayNode*)node1, (ArrayNode*)node2);
+    case TTupleTag:
+        return ttupleEqual((TTupleNode*)node1, (TTupleNode*)node2);
     case VoidTag:
         return 1;
     default:
@@ -81,6 +102,139 @@ int itypeIsSame(INode *node1, INode *node2) {
     }
 }
 
+// Mix another value into a type hash
+#define itypeHashMix(hash, val) ((hash) ^ ((size_t)(val) + 0x9e3779b9 + ((hash) << 6) + ((hash) >> 2)))
+
+// Return a hash of the type, such that itypeIsSame types always hash the same
+// Named types hash on their declaration node's address; others structurally
+size_t itypeHash(INode *type) {
+    type = itypeGetTypeDcl(type);
+    size_t hash = type->tag;
+    switch (type->tag) {
+    case FnSigTag:
+    {
+        FnSigNode *fnsig = (FnSigNode*)type;
+        hash = itypeHashMix(hash, itypeHash(fnsig->rettype));
+        return itypeHashMix(hash, fnsig->parms->used);
+    }
+    case RefTag:
+    case ArrayRefTag:
+    case VirtRefTag:
+    {
+        RefNode *ref = (RefNode*)type;
+        INode *perm = ref->perm->tag == TypeNameUseTag ? ((NameUseNode*)ref->perm)->dclnode : ref->perm;
+        hash = itypeHashMix(hash, itypeHash(ref->pvtype));
+        hash = itypeHashMix(hash, (size_t)perm >> 4);
+        hash = itypeHashMix(hash, (size_t)ref->region >> 4);
+        return itypeHashMix(hash, ref->flags & FlagRefNull);
+    }
+    case PtrTag:
+        return itypeHashMix(hash, itypeHash(((PtrNode*)type)->pvtype));
+    case ArrayTag:
+        hash = itypeHashMix(hash, ((ArrayNode*)type)->size);
+        return itypeHashMix(hash, itypeHash(((ArrayNode*)type)->elemtype));
+    case TTupleTag:
+    {
+        INode **nodesp;
+        uint32_t cnt;
+        for (nodesFor(((TTupleNode*)type)->types, cnt, nodesp))
+            hash = itypeHashMix(hash, itypeHash(*nodesp));
+        return hash;
+    }
+    case VoidTag:
+        return hash;
+    default:
+        return itypeHashMix(hash, (size_t)type >> 4);
+    }
+}
+
+// The interned structural types: an open-addressing hash table keyed on itypeHash.
+// Interning happens only once a type has been type checked, so that its parts are
+// resolved and will not change. Since each interned type's parts are themselves
+// interned (bottom-up), comparing a new type against a table entry is mostly pointer compares.
+typedef struct ITypeInternSlot {
+    size_t hash;
+    INode *type;    // NULL if empty
+} ITypeInternSlot;
+
+ITypeInternSlot *itypeInternTbl = NULL;
+size_t itypeInternSize = 0;     // Number of slots (power of 2)
+size_t itypeInternUsed = 0;     // Number of filled slots
+
+// Double the size of the intern table (or create it)
+void itypeInternGrow() {
+    ITypeInternSlot *oldtbl = itypeInternTbl;
+    size_t oldsize = itypeInternSize;
+    itypeInternSize = oldsize == 0 ? 1024 : oldsize << 1;
+    itypeInternTbl = memAllocBlk(itypeInternSize * sizeof(ITypeInternSlot));
+    memset(itypeInternTbl, 0, itypeInternSize * sizeof(ITypeInternSlot));
+    size_t mask = itypeInternSize - 1;
+    for (ITypeInternSlot *oldslot = oldtbl; oldslot < oldtbl + oldsize; ++oldslot) {
+        if (oldslot->type) {
+            size_t tbli = oldslot->hash & mask;
+            while (itypeInternTbl[tbli].type)
+                tbli = (tbli + 1) & mask;
+            itypeInternTbl[tbli] = *oldslot;
+        }
+    }
+}
+
+// Return 1 if the type's structure is complete enough to be interned
+int itypeInternable(INode *type) {
+    switch (type->tag) {
+    case RefTag:
+    case ArrayRefTag:
+    case VirtRefTag:
+    {
+        RefNode *ref = (RefNode*)type;
+        return ref->perm && ref->pvtype && ref->pvtype != unknownType;
+    }
+    case PtrTag:
+        return ((PtrNode*)type)->pvtype != unknownType;
+    case ArrayTag:
+        return ((ArrayNode*)type)->elemtype != unknownType;
+    case TTupleTag:
+        return 1;
+    default:
+        // Function signatures are not interned, as each owns its parameter declarations
+        return 0;
+    }
+}
+
+// Return the one interned instance of a type-checked structural type
+INode *itypeIntern(INode *type) {
+    if (type->flags & InternedUse)
+        return *itypeInternedp(type);
+    if ((type->flags & InternedType) || errors || !itypeInternable(type))
+        return type;
+
+    // Keep table at no more than 50% utilization
+    if ((itypeInternUsed + 1) << 1 > itypeInternSize)
+        itypeInternGrow();
+
+    size_t hash = itypeHash(type);
+    size_t mask = itypeInternSize - 1;
+    size_t tbli = hash & mask;
+    while (1) {
+        ITypeInternSlot *slot = &itypeInternTbl[tbli];
+        if (slot->type == NULL) {
+            slot->hash = hash;
+            slot->type = type;
+            ++itypeInternUsed;
+            type->flags |= InternedType;
+            ((ITypeNode*)type)->llvmtype = NULL;
+            return type;
+        }
+        // This use keeps its node, for its source position, but resolves to the interned instance
+        if (slot->hash == hash && itypeIsSame(slot->type, type)) {
+            *itypeInternedp(type) = slot->type;
+            type->flags |= InternedUse;
+            return slot->type;
+        }
+        tbli = (tbli + 1) & mask;
+    }
+}
+
 // Is totype equivalent or a subtype of fromtype
 TypeCompare itypeMatches(INode *totype, INode *fromtype, SubtypeConstraint constraint) {
     fromtype = itypeGetTypeDcl(fromtype);
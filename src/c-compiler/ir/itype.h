@@ -55,12 +55,22 @@ INode *itypeGetTypeDcl(INode *node);
 INode *itypeGetDerefTypeDcl(INode *node);
 
 // Type check node, expecting it to be a type. Give error and return 0, if not.
+// A checked structural type keeps its node, and resolves to its interned instance.
 int itypeTypeCheck(TypeCheckState *pstate, INode **node);
 
+// Return the one interned instance of a type-checked structural type
+// (reference, pointer, array or type tuple), adding type to the table if it is new.
+// Other types are returned unchanged. A type whose interned instance is another node
+// keeps its node, so diagnostics point at this use, and resolves to that instance.
+INode *itypeIntern(INode *type);
+
 // Return 1 if nominally (or structurally) identical, 0 otherwise.
 // Nodes must both be types, but may be name use or declare nodes.
 int itypeIsSame(INode *node1, INode *node2);
 
+// Return a hash of the type, such that itypeIsSame types always hash the same
+size_t itypeHash(INode *type);
+
 // Is totype equivalent or a subtype of fromtype
 TypeCompare itypeMatches(INode *totype, INode *fromtype, SubtypeConstraint constraint);
 
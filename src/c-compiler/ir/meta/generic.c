@@ -19,6 +19,8 @@ GenericNode *newMacroDclNode(Name *namesym) {
     gennode->parms = newNodes(4);
     gennode->body = NULL;
     gennode->memonodes = newNodes(4);
+    gennode->memotbl = NULL;
+    gennode->memoavail = 0;
     return gennode;
 }
 
@@ -89,6 +91,63 @@ void genericNameTypeCheck(TypeCheckState *pstate, NameUseNode **gennode) {
     inodeTypeCheckAny(pstate, (INode**)gennode);
 }
 
+// Hash a generic call's type arguments
+size_t genericMemoHash(Nodes *args) {
+    size_t hash = args->used;
+    INode **nodesp;
+    uint32_t cnt;
+    for (nodesFor(args, cnt, nodesp))
+        hash = (hash * 31) ^ itypeHash(*nodesp);
+    return hash;
+}
+
+// Find the memo slot for some type arguments: either empty or holding a match.
+// A matching instance must have the same hash and the same types
+GenericMemoSlot *genericMemoFindSlot(GenericNode *genericnode, Nodes *args, size_t hash) {
+    uint32_t mask = genericnode->memoavail - 1;
+    uint32_t tbli = hash & mask;
+    while (1) {
+        GenericMemoSlot *slot = &genericnode->memotbl[tbli];
+        if (slot->pos == 0)
+            return slot;
+        if (slot->hash == hash) {
+            FnCallNode *fncallprior = (FnCallNode *)nodesGet(genericnode->memonodes, slot->pos - 1);
+            int match = 1;
+            INode **priornodesp;
+            uint32_t priorcnt;
+            INode **nownodesp = &nodesGet(args, 0);
+            for (nodesFor(fncallprior->args, priorcnt, priornodesp)) {
+                if (!itypeIsSame(*priornodesp, *nownodesp++)) {
+                    match = 0;
+                    break;
+                }
+            }
+            if (match)
+                return slot;
+        }
+        tbli = (tbli + 1) & mask;
+    }
+}
+
+// Double the size of the generic's memo index (or create it), re-indexing its instances
+void genericMemoGrow(GenericNode *genericnode) {
+    GenericMemoSlot *oldtbl = genericnode->memotbl;
+    uint32_t oldavail = genericnode->memoavail;
+    genericnode->memoavail = oldavail == 0 ? 16 : oldavail << 1;
+    genericnode->memotbl = (GenericMemoSlot *)memAllocBlk(genericnode->memoavail * sizeof(GenericMemoSlot));
+    memset(genericnode->memotbl, 0, genericnode->memoavail * sizeof(GenericMemoSlot));
+
+    uint32_t mask = genericnode->memoavail - 1;
+    for (uint32_t oldslot = 0; oldslot < oldavail; ++oldslot) {
+        if (oldtbl[oldslot].pos == 0)
+            continue;
+        uint32_t tbli = oldtbl[oldslot].hash & mask;
+        while (genericnode->memotbl[tbli].pos != 0)
+            tbli = (tbli + 1) & mask;
+        genericnode->memotbl[tbli] = oldtbl[oldslot];
+    }
+}
+
 // Verify arguments are types, check if instantiated, instantiate if needed and return ptr to it
 INode *genericMemoize(TypeCheckState *pstate, FnCallNode *fncall) {
     GenericNode *genericnode = (GenericNode*)((NameUseNode*)fncall->objfn)->dclnode;
@@ -108,28 +167,18 @@ INode *genericMemoize(TypeCheckState *pstate, FnCallNode *fncall) {
 
     // Check whether these types have already been instantiated for this generic
     // memonodes holds pairs of nodes: an FnCallNode and what it instantiated
-    // A match is the first FnCallNode whose types match what we want
-    for (nodesFor(genericnode->memonodes, cnt, nodesp)) {
-        FnCallNode *fncallprior = (FnCallNode *)*nodesp;
-        nodesp++; cnt--; // skip to instance node
-        int match = 1;
-        INode **priornodesp;
-        uint32_t priorcnt;
-        INode **nownodesp = &nodesGet(fncall->args, 0);
-        for (nodesFor(fncallprior->args, priorcnt, priornodesp)) {
-            if (!itypeIsSame(*priornodesp, *nownodesp)) {
-                match = 0;
-                break;
-            }
-            nownodesp++;
-        }
-        if (match) {
-            // Return a namenode pointing to dcl instance
-            NameUseNode *fnuse = newNameUseNode(genericnode->namesym);
-            fnuse->tag = isTypeNode(*nodesp)? TypeNameUseTag : VarNameUseTag;
-            fnuse->dclnode = *nodesp;
-            return (INode *)fnuse;
-        }
+    // memotbl indexes these pairs by a hash of the FnCallNode's type arguments
+    if ((genericnode->memonodes->used + 2) >= genericnode->memoavail)
+        genericMemoGrow(genericnode);
+    size_t hash = genericMemoHash(fncall->args);
+    GenericMemoSlot *slot = genericMemoFindSlot(genericnode, fncall->args, hash);
+    if (slot->pos != 0) {
+        // Return a namenode pointing to dcl instance
+        INode *instance = nodesGet(genericnode->memonodes, slot->pos);
+        NameUseNode *fnuse = newNameUseNode(genericnode->namesym);
+        fnuse->tag = isTypeNode(instance)? TypeNameUseTag : VarNameUseTag;
+        fnuse->dclnode = instance;
+        return (INode *)fnuse;
     }
 
     // No match found, instantiate the dcl generic
@@ -142,8 +191,14 @@ INode *genericMemoize(TypeCheckState *pstate, FnCallNode *fncall) {
     inodeTypeCheckAny(pstate, &instance);
 
     // Remember instantiation for the future
+    // Note: type checking the instance may have memoized other instances of this generic
     nodesAdd(&genericnode->memonodes, (INode*)fncall);
     nodesAdd(&genericnode->memonodes, instance);
+    if ((genericnode->memonodes->used + 2) >= genericnode->memoavail)
+        genericMemoGrow(genericnode);
+    slot = genericMemoFindSlot(genericnode, fncall->args, hash);
+    slot->hash = hash;
+    slot->pos = genericnode->memonodes->used - 1;
 
     // Return a namenode pointing to fndcl instance
     NameUseNode *fnuse = newNameUseNode(genericnode->namesym);
@@ -7,13 +7,21 @@
 #ifndef generic_h
 #define generic_h
 
+// Slot in a generic's hash index of memoized instances
+typedef struct GenericMemoSlot {
+    size_t hash;             // Hash of the instance's type arguments
+    uint32_t pos;            // Position of the instance in memonodes (0=empty slot)
+} GenericMemoSlot;
+
 // Generic declaration node
 typedef struct GenericNode {
     IExpNodeHdr;             // 'vtype': type of this name's value
     Name *namesym;
     Nodes *parms;            // Declared parameter nodes w/ defaults (GenVarTag)
     INode *body;             // The body of the generic
-    Nodes *memonodes;        // Pairs of memoized generic calls and cloned bodies
+    Nodes *memonodes;        // Pairs of memoized generic calls and cloned bodies (in instance order)
+    GenericMemoSlot *memotbl; // Hash index into memonodes, keyed on the type arguments
+    uint32_t memoavail;      // Number of slots in memotbl (power of 2)
 } GenericNode;
 
 // Create a new macro declaraction node
@@ -28,6 +28,9 @@ Name *selfTypeName; // "Self"
 Name *thisName;  // "this"
 Name *cloneName; // "clone" method
 Name *finalName; // "final" method
+Name *allocName; // "alloc" method of a region
+Name *freeName;  // "free" method of a region
+Name *reallocName; // "realloc" method of a region
 
 Name *plusEqName;   // "+="
 Name *minusEqName;  // "-="
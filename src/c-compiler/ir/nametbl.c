@@ -7,8 +7,12 @@
  * All names are hashed and stored in the global name table.
  * The name's table entry points to an allocated block that holds its current "value", computed hash and c-string.
  *
- * Dan Bernstein's djb algorithm is the hash function for strings, being fast and effective
- * The name table uses open addressing (vs. chaining) with quadratic probing (no Robin Hood).
+ * The hash function is a wyhash-style mix over 8-byte words of the string.
+ * The name table is a Swiss table: besides the array of Name pointers, a parallel
+ * array of control bytes holds, for every slot, either the empty marker or 7 bits of
+ * the name's hash. A lookup compares a whole group of 16 control bytes against
+ * the hash's tag at once, and only looks at names whose tag matches.
+ * Groups are probed triangularly. Names are never removed, so there are no tombstones.
  * The name table starts out large, but will double in size whenever it gets close to full.
  *
  * This source file is part of the Cone Programming Language C compiler
@@ -19,60 +23,203 @@
 #include "memory.h"
 
 #include <stdio.h>
+#include <stdint.h>
 #include <assert.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NameGroupSSE2
+#endif
+
 // Public globals
-size_t gNameTblInitSize = 16384;    // Initial maximum number of unique names (must be power of 2)
-unsigned int gNameTblUtil = 50;     // % utilization that triggers doubling of table
+size_t gNameTblInitSize = 4096;     // Initial maximum number of unique names (must be power of 2)
+unsigned int gNameTblUtil = 80;     // % utilization that triggers doubling of table
 
 // Private globals
 Name **gNameTable = NULL;           // The name table array
+uint8_t *gNameTblCtrl = NULL;       // Control byte per slot, followed by a copy of the first group
 size_t gNameTblAvail = 0;           // Number of allocated name table slots (power of 2)
 size_t gNameTblCeil = 0;            // Ceiling that triggers table growth
 size_t gNameTblUsed = 0;            // Number of name table slots used
 
-/** String hash function (djb: Dan Bernstein)
- * Ref: http://www.cse.yorku.ca/~oz/hash.html
- * Ref: http://www.partow.net/programming/hashfunctions/#AvailableHashFunctions
- * Would this help?: hash ^= hash >> 11; // Extra randomness for long names?
- */
-#define nameHashFn(hash, strp, strl) \
-{ \
-    char *p; \
-    size_t len = strl; \
-    p = strp; \
-    hash = 5381; \
-    while (len--) \
-        hash = ((hash << 5) + hash) ^ ((size_t)*p++); \
+// Control byte for an empty slot. A full slot's control byte is its name's tag.
+#define NameCtrlEmpty 0x80
+// The tag is the hash's low 7 bits. The group probed first comes from the rest.
+#define nameHashTag(hash) ((uint8_t)((hash) & 0x7F))
+#define nameHashPos(hash) ((size_t)((hash) >> 7))
+
+// ************************ Hash function *******************************
+
+// 64x64->128 bit multiply, folded back to 64 bits by xor of its halves
+static inline uint64_t nameHashMix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return lo ^ hi;
+#endif
+}
+
+// Unaligned little-endian loads of 8, 4 and 1-3 bytes
+static inline uint64_t nameHashRd8(const char *p) {
+    uint64_t v; memcpy(&v, p, 8); return v;
+}
+static inline uint64_t nameHashRd4(const char *p) {
+    uint32_t v; memcpy(&v, p, 4); return v;
+}
+static inline uint64_t nameHashRd3(const char *p, size_t len) {
+    return ((uint64_t)(uint8_t)p[0] << 16) | ((uint64_t)(uint8_t)p[len >> 1] << 8) | (uint8_t)p[len - 1];
+}
+
+#define NameHashSeed 0xa0761d6478bd642full
+#define NameHashK1   0xe7037ed1a0b428dbull
+#define NameHashK2   0x8ebc6af09c88c6e3ull
+
+/** Hash a string, 8 bytes at a time (after wyhash, by Wang Yi)
+ * Ref: https://github.com/wangyi-fudan/wyhash
+ * Short names, the common case, are hashed using two (possibly overlapping) loads
+ * with no loop. Nothing is read outside the string. */
+size_t nametblHash(char *strp, size_t strl) {
+    const char *p = strp;
+    uint64_t seed = NameHashSeed;
+    uint64_t a, b;
+    if (strl <= 16) {
+        if (strl >= 4) {
+            size_t off = (strl >> 3) << 2;
+            a = (nameHashRd4(p) << 32) | nameHashRd4(p + off);
+            b = (nameHashRd4(p + strl - 4) << 32) | nameHashRd4(p + strl - 4 - off);
+        }
+        else if (strl > 0) {
+            a = nameHashRd3(p, strl);
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else {
+        size_t len = strl;
+        while (len > 16) {
+            seed = nameHashMix(nameHashRd8(p) ^ NameHashK1, nameHashRd8(p + 8) ^ seed);
+            p += 16;
+            len -= 16;
+        }
+        a = nameHashRd8(p + len - 16);
+        b = nameHashRd8(p + len - 8);
+    }
+    return (size_t)nameHashMix(NameHashK1 ^ strl, nameHashMix(a ^ NameHashK1, b ^ seed));
+}
+
+// ************************ Control byte groups *******************************
+
+// A group of control bytes is matched all at once. The result of a match
+// is a bitmask, with a set bit for every matching control byte in the group.
+#ifdef NameGroupSSE2
+// A group is 16 control bytes, one bit per byte in the mask
+#define NameGroupSize 16
+typedef uint32_t NameGroupMask;
+
+// Position in the group of the mask's first match (the mask is never 0)
+#define nameGroupFirst(mask) ((size_t)nameCtz(mask))
+
+// Mask of control bytes that match tag
+static inline NameGroupMask nameGroupMatch(uint8_t *ctrl, uint8_t tag) {
+    __m128i group = _mm_loadu_si128((__m128i*)ctrl);
+    return (NameGroupMask)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
 }
 
-/** Modulo operation that calculates primary table entry from name's hash.
- * 'size' is always a power of 2 */
-#define nameHashMod(hash, size) \
-    (assert(((size)&((size)-1))==0), (size_t) ((hash) & ((size)-1)) )
-
-/** Calculate index into name table for a name using linear probing
- * The table's slot at index is either empty or matches the provided name/hash
- */
-#define nametblFindSlot(tblp, hash, strp, strl) \
-{ \
-    size_t tbli; \
-    for (tbli = nameHashMod(hash, gNameTblAvail);;) { \
-        Name *slot; \
-        slot = gNameTable[tbli]; \
-        if (slot==NULL || (slot->hash == hash && slot->namesz == strl && strncmp(strp, &slot->namestr, strl)==0)) \
-            break; \
-        tbli = nameHashMod(tbli + 1, gNameTblAvail); \
-    } \
-    tblp = &gNameTable[tbli]; \
+// Mask of control bytes for empty slots
+static inline NameGroupMask nameGroupEmpty(uint8_t *ctrl) {
+    return (NameGroupMask)_mm_movemask_epi8(_mm_loadu_si128((__m128i*)ctrl));
+}
+
+#else
+// Portable version: a group is one 8-byte word, matched using bit tricks.
+// Each byte's match is its high bit in the mask. Matching may report a false
+// positive next to a true match, which is harmless as the name is compared anyway.
+#define NameGroupSize 8
+typedef uint64_t NameGroupMask;
+#define NameGroupLsbs 0x0101010101010101ull
+#define NameGroupMsbs 0x8080808080808080ull
+
+#define nameGroupFirst(mask) ((size_t)nameCtz(mask) >> 3)
+
+static inline NameGroupMask nameGroupMatch(uint8_t *ctrl, uint8_t tag) {
+    uint64_t group;
+    memcpy(&group, ctrl, 8);
+    group ^= NameGroupLsbs * tag;
+    return (group - NameGroupLsbs) & ~group & NameGroupMsbs;
+}
+
+static inline NameGroupMask nameGroupEmpty(uint8_t *ctrl) {
+    uint64_t group;
+    memcpy(&group, ctrl, 8);
+    return group & NameGroupMsbs;
+}
+#endif
+
+// Count of trailing zero bits (mask is never 0)
+static inline unsigned nameCtz(uint64_t mask) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(mask);
+#else
+    unsigned n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// ************************ Name table *******************************
+
+/** Find the slot holding the name that matches string and hash,
+ * or else the empty slot where that name belongs */
+Name **nametblFindSlot(char *strp, size_t strl, size_t hash) {
+    size_t mask = gNameTblAvail - 1;
+    size_t pos = nameHashPos(hash) & mask;
+    uint8_t tag = nameHashTag(hash);
+    size_t step = 0;
+    while (1) {
+        uint8_t *ctrl = &gNameTblCtrl[pos];
+        NameGroupMask match = nameGroupMatch(ctrl, tag);
+        while (match) {
+            Name **slotp = &gNameTable[(pos + nameGroupFirst(match)) & mask];
+            Name *slot = *slotp;
+            if (slot->hash == hash && slot->namesz == strl && memcmp(strp, &slot->namestr, strl) == 0)
+                return slotp;
+            match &= match - 1;
+        }
+        NameGroupMask empty = nameGroupEmpty(ctrl);
+        if (empty)
+            return &gNameTable[(pos + nameGroupFirst(empty)) & mask];
+        step += NameGroupSize;
+        pos = (pos + step) & mask;
+    }
+}
+
+/** Fill an empty slot with name. The first group's control bytes are
+ * mirrored after the last slot, so that a group can be loaded from any slot. */
+void nametblFillSlot(Name **slotp, Name *name) {
+    size_t tbli = slotp - gNameTable;
+    *slotp = name;
+    gNameTblCtrl[tbli] = nameHashTag(name->hash);
+    if (tbli < NameGroupSize)
+        gNameTblCtrl[gNameTblAvail + tbli] = nameHashTag(name->hash);
 }
 
 /** Grow the name table, by either creating it or doubling its size */
 void nametblGrow() {
     size_t oldTblAvail;
     Name **oldTable;
-    size_t newTblMem;
     size_t oldslot;
 
     // Preserve old table info
@@ -81,25 +228,18 @@ void nametblGrow() {
 
     // Allocate and initialize new name table
     gNameTblAvail = oldTblAvail==0? gNameTblInitSize : oldTblAvail<<1;
+    assert((gNameTblAvail & (gNameTblAvail - 1)) == 0 && gNameTblAvail >= NameGroupSize);
     gNameTblCeil = (gNameTblUtil * gNameTblAvail) / 100;
-    newTblMem = gNameTblAvail * sizeof(Name*);
-    gNameTable = (Name**) memAllocBlk(newTblMem);
-    memset(gNameTable, 0, newTblMem); // Fill with NULL pointers & 0s
+    gNameTable = (Name**) memAllocBlk(gNameTblAvail * sizeof(Name*));
+    memset(gNameTable, 0, gNameTblAvail * sizeof(Name*)); // Fill with NULL pointers
+    gNameTblCtrl = (uint8_t*) memAllocBlk(gNameTblAvail + NameGroupSize);
+    memset(gNameTblCtrl, NameCtrlEmpty, gNameTblAvail + NameGroupSize);
 
-    // Copy existing name slots to re-hashed positions in new table
+    // Copy existing names to re-hashed positions in new table
     for (oldslot=0; oldslot < oldTblAvail; oldslot++) {
-        Name **oldslotp, **newslotp;
-        oldslotp = &oldTable[oldslot];
-        if (*oldslotp) {
-            char *strp;
-            size_t strl, hash;
-            Name *oldnamep = *oldslotp;
-            strp = &oldnamep->namestr;
-            strl = oldnamep->namesz;
-            hash = oldnamep->hash;
-            nametblFindSlot(newslotp, hash, strp, strl);
-            *newslotp = *oldslotp;
-        }
+        Name *oldnamep = oldTable[oldslot];
+        if (oldnamep)
+            nametblFillSlot(nametblFindSlot(&oldnamep->namestr, oldnamep->namesz, oldnamep->hash), oldnamep);
     }
     // memFreeBlk(oldTable);
 }
@@ -107,36 +247,32 @@ void nametblGrow() {
 /** Get pointer to interned Name in Global Name Table matching string. 
  * For unknown name, this allocates memory for the string and adds it to name table. */
 Name *nametblFind(char *strp, size_t strl) {
-    size_t hash;
-    Name **slotp;
-
-    // Hash provide string into table
-    nameHashFn(hash, strp, strl);
-    nametblFindSlot(slotp, hash, strp, strl);
+    size_t hash = nametblHash(strp, strl);
+    Name **slotp = nametblFindSlot(strp, strl, hash);
+    if (*slotp)
+        return *slotp;
 
     // If not already a name, allocate memory for string and add to table
-    if (*slotp == NULL) {
-        Name *newname;
-        // Double table if it has gotten too full
-        if (++gNameTblUsed >= gNameTblCeil) {
-            nametblGrow();
-            nametblFindSlot(slotp, hash, strp, strl);
-        }
-
-        // Allocate and populate name info
-        *slotp = newname = memAllocBlk(sizeof(Name) + strl);
-        memcpy(&newname->namestr, strp, strl);
-        (&newname->namestr)[strl] = '\0';
-        newname->hash = hash;
-        newname->namesz = (unsigned char)strl;
-        newname->node = NULL;        // Node not yet known
+    // Double table if it has gotten too full
+    if (++gNameTblUsed >= gNameTblCeil) {
+        nametblGrow();
+        slotp = nametblFindSlot(strp, strl, hash);
     }
-    return *slotp;
+
+    // Allocate and populate name info
+    Name *newname = memAllocBlk(sizeof(Name) + strl);
+    memcpy(&newname->namestr, strp, strl);
+    (&newname->namestr)[strl] = '\0';
+    newname->hash = hash;
+    newname->namesz = (unsigned char)strl;
+    newname->node = NULL;        // Node not yet known
+    nametblFillSlot(slotp, newname);
+    return newname;
 }
 
 // Return size of unused space for name table
 size_t nametblUnused() {
-    return (gNameTblAvail-gNameTblUsed)*sizeof(Name*);
+    return (gNameTblAvail-gNameTblUsed)*(sizeof(Name*) + 1);
 }
 
 // Initialize name table
@@ -150,6 +286,9 @@ void nametblInit() {
     thisName = nametblFind("this", 4);
     cloneName = nametblFind("clone", 5);
     finalName = nametblFind("final", 5);
+    allocName = nametblFind("alloc", 5);
+    freeName = nametblFind("free", 4);
+    reallocName = nametblFind("realloc", 7);
 
     plusEqName = nametblFind("+=", 2);
     minusEqName = nametblFind("-=", 2);
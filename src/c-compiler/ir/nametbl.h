@@ -31,6 +31,9 @@ void nametblInit();
 // For an unknown name, it allocates memory for the string and adds it to name table.
 Name *nametblFind(char *strp, size_t strl);
 
+// The hash of a string, as used by the name table (and kept in a Name)
+size_t nametblHash(char *strp, size_t strl);
+
 // Return how many bytes have been allocated for global name table but not yet used
 size_t nametblUnused();
 
@@ -21,6 +21,7 @@ FnDclNode *newFnDclNode(Name *namesym, uint16_t flags, INode *type, INode *val)
     name->llvmvar = NULL;
     name->genname = namesym? &namesym->namestr : "";
     name->nextnode = NULL;
+    name->versions = NULL;
     return name;
 }
 
@@ -108,8 +109,8 @@ void fnDclTypeCheck(TypeCheckState *pstate, FnDclNode *fnnode) {
         || ((fnnode->flags & FlagMethFld) && pstate->typenode->tag == StructTag && (pstate->typenode->flags & TraitType)))
         return;
 
-    // Ensure self parameter on a method is (reference to) its enclosing type
-    if (fnnode->flags & FlagMethFld) {
+    // Ensure self parameter on a method is (reference to) its enclosing type (regions have no self)
+    if ((fnnode->flags & FlagMethFld) && pstate->typenode->tag != RegionTag) {
         INode *selfparm = nodesGet(((FnSigNode *)(fnnode->vtype))->parms, 0);
         if (iexpGetDerefTypeDcl(selfparm) != pstate->typenode)
             errorMsgNode((INode*)fnnode, ErrorInvType, "self parameter for a method must match, or be a reference to, its type");
@@ -128,9 +129,15 @@ void fnDclTypeCheck(TypeCheckState *pstate, FnDclNode *fnnode) {
     // We run data flow separately as it requires type info which is inferred bottoms-up
     if (errors)
         return;
-    flowAliasInit();
+    MemTmpMark tmpmark = memTmpMark();
+    flowInit();
     FlowState fstate;
     fstate.fnsig = (FnSigNode *)fnnode->vtype;
     fstate.scope = 1;
     blockFlow(&fstate, (BlockNode **)&fnnode->value);
+    memTmpRelease(tmpmark);
+
+    // Spare loops' array indexes the bounds checks they provably do not need
+    if (errors == 0)
+        boundsFn(fnnode);
 }
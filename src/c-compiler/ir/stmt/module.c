@@ -59,7 +59,7 @@ void modPrint(ModuleNode *mod) {
     if (mod->namesym)
         inodeFprint("module %s\n", &mod->namesym->namestr);
     else
-        inodeFprint("IR for program %s\n", mod->lexer->url);
+        inodeFprint("IR for program %s\n", lexSrcFile(mod->srcloc)->url);
     inodePrintIncr();
     for (nodesFor(mod->nodes, cnt, nodesp)) {
         inodePrintIndent();
@@ -91,7 +91,11 @@ void modNameRes(NameResState *pstate, ModuleNode *mod) {
     INode **nodesp;
     uint32_t cnt;
     for (nodesFor(mod->nodes, cnt, nodesp)) {
-        inodeNameRes(pstate, nodesp);
+        // A declared region is only resolved here, not at each reference that names it
+        if ((*nodesp)->tag == RegionTag)
+            regionNameRes(pstate, (StructNode*)*nodesp);
+        else
+            inodeNameRes(pstate, nodesp);
     }
 
     // Switch name table back to owner module
@@ -129,7 +133,10 @@ void modTypeCheck(TypeCheckState *pstate, ModuleNode *mod) {
     // Now we can process the full node info
     if (errors == 0) {
         for (nodesFor(mod->nodes, cnt, nodesp)) {
-            inodeTypeCheckAny(pstate, nodesp);
+            if ((*nodesp)->tag == RegionTag)
+                regionTypeCheck(pstate, (StructNode*)*nodesp);
+            else
+                inodeTypeCheckAny(pstate, nodesp);
         }
     }
 }
\ No newline at end of file
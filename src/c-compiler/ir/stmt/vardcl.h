@@ -19,10 +19,17 @@ typedef struct VarDclNode {
     uint16_t index;            // index within this scope (e.g., parameter number)
     uint16_t flowflags;        // Data flow pass permanent flags
     uint16_t flowtempflags;    // Data flow pass temporary flags
+    LLVMValueRef llvmdropflag; // LLVM's handle for a VarDropFlag variable's flag (for generation)
 } VarDclNode;
 
+enum VarFlow {
+    VarDropFlag = 0x0001        // Moved on some paths only: a runtime flag says if it still has a value to drop
+};
+
 enum VarFlowTemp {
-    VarInitialized = 0x0001     // Variable has been initialized
+    VarInitialized = 0x0001,    // Variable has been initialized
+    VarMoved = 0x0002,          // Variable's value has been moved out of it
+    VarMaybeMoved = 0x0004      // Variable's value has been moved out of it on some paths, but not all
 };
 
 VarDclNode *newVarDclNode(Name *namesym, uint16_t tag, INode *perm);
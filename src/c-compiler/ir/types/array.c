@@ -13,6 +13,7 @@ ArrayNode *newArrayNode() {
     newNode(anode, ArrayNode, ArrayTag);
     anode->namesym = anonName;
     anode->llvmtype = NULL;
+    anode->interned = NULL;
     iNsTypeInit((INsTypeNode*)anode, 0);
     return anode;
 }
@@ -29,6 +30,7 @@ ArrayNode *newArrayNodeTyped(size_t size, INode *elemtype) {
 INode *cloneArrayNode(CloneState *cstate, ArrayNode *node) {
     ArrayNode *newnode = memAllocBlk(sizeof(ArrayNode));
     memcpy(newnode, node, sizeof(ArrayNode));
+    newnode->flags &= ~(InternedType | InternedUse);
     newnode->elemtype = cloneNode(cstate, node->elemtype);
     return (INode *)newnode;
 }
@@ -13,6 +13,7 @@ typedef struct ArrayNode {
     INsTypeNodeHdr;
     uint32_t size;    // LLVM 5 C-interface is restricted to 32-bits
     INode *elemtype;
+    INode *interned;  // Interned instance of this type, if another node (see InternedUse)
 } ArrayNode;
 
 ArrayNode *newArrayNode();
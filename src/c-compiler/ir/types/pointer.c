@@ -12,6 +12,8 @@
 PtrNode *newPtrNode() {
     PtrNode *ptrnode;
     newNode(ptrnode, PtrNode, PtrTag);
+    ptrnode->llvmtype = NULL;
+    ptrnode->interned = NULL;
     return ptrnode;
 }
 
@@ -19,6 +21,7 @@ PtrNode *newPtrNode() {
 INode *clonePtrNode(CloneState *cstate, PtrNode *node) {
     PtrNode *newnode = memAllocBlk(sizeof(PtrNode));
     memcpy(newnode, node, sizeof(PtrNode));
+    newnode->flags &= ~(InternedType | InternedUse);
     newnode->pvtype = cloneNode(cstate, node->pvtype);
     return (INode *)newnode;
 }
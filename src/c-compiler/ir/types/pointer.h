@@ -10,8 +10,9 @@
 
 // For pointers
 typedef struct PtrNode {
-    INodeHdr;
+    ITypeNodeHdr;
     INode *pvtype;    // Value type
+    INode *interned;  // Interned instance of this type, if another node (see InternedUse)
 } PtrNode;
 
 // Create a new pointer type whose info will be filled in afterwards
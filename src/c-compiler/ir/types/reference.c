@@ -12,6 +12,8 @@
 RefNode *newRefNode() {
     RefNode *refnode;
     newNode(refnode, RefNode, RefTag);
+    refnode->llvmtype = NULL;
+    refnode->interned = NULL;
     return refnode;
 }
 
@@ -19,6 +21,7 @@ RefNode *newRefNode() {
 INode *cloneRefNode(CloneState *cstate, RefNode *node) {
     RefNode *newnode = memAllocBlk(sizeof(RefNode));
     memcpy(newnode, node, sizeof(RefNode));
+    newnode->flags &= ~(InternedType | InternedUse);
     newnode->region = cloneNode(cstate, node->region);
     newnode->perm = cloneNode(cstate, node->perm);
     newnode->pvtype = cloneNode(cstate, node->pvtype);
@@ -29,7 +32,7 @@ INode *cloneRefNode(CloneState *cstate, RefNode *node) {
 void refAdoptInfections(RefNode *refnode) {
     if (refnode->perm == NULL || refnode->pvtype == unknownType)
         return;  // Wait until we have this info
-    if (!(permGetFlags(refnode->perm) & MayAlias) || refnode->region == (INode*)soRegion)
+    if (!(permGetFlags(refnode->perm) & MayAlias) || regionFrees(refnode->region))
         refnode->flags |= MoveType;
     if (refnode->perm == (INode*)mutPerm || refnode->perm == (INode*)constPerm 
         || (refnode->pvtype->flags & ThreadBound))
@@ -12,11 +12,12 @@
 
 // Reference node
 typedef struct RefNode {
-    INodeHdr;
+    ITypeNodeHdr;
     INode *pvtype;    // Value type
     INode *perm;      // Permission
     INode *region;    // Region
     uint16_t scope;   // Lifetime
+    INode *interned;  // Interned instance of this type, if another node (see InternedUse)
 } RefNode;
 
 // Create a new reference type whose info will be filled in afterwards
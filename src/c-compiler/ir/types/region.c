@@ -0,0 +1,84 @@
+/** Handling for regions (allocators)
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir.h"
+
+// Does dropping a reference of this region free what it refers to? (so, pool, or a region with free)
+int regionFrees(INode *region) {
+    return region == (INode*)soRegion || region == (INode*)poolRegion
+        || (!regionCounts(region) && regionFindFn(region, freeName) != NULL);
+}
+
+// Are this region's references reference counted? (rc, or a region declared on rc)
+int regionCounts(INode *region) {
+    return region == (INode*)rcRegion || (region->tag == RegionTag && (region->flags & CountedRegion));
+}
+
+// Return a declared region's alloc, free or realloc method (NULL if it has none, as built-in regions do)
+FnDclNode *regionFindFn(INode *region, Name *name) {
+    if (region->tag != RegionTag)
+        return NULL;
+    INode *fn = iNsTypeFindFnField((INsTypeNode*)region, name);
+    return (fn && fn->tag == FnDclTag) ? (FnDclNode*)fn : NULL;
+}
+
+// Name resolution of a declared region, done once at its declaration
+void regionNameRes(NameResState *pstate, StructNode *node) {
+    structNameRes(pstate, node);
+    // `region Name: rc` counts its references, as rc does, allocating them with its own methods
+    if (node->basetrait) {
+        if (node->basetrait->tag != TypeNameUseTag || itypeGetTypeDcl(node->basetrait) != (INode*)rcRegion)
+            errorMsgNode(node->basetrait, ErrorInvType, "A region may only be declared on rc");
+        else
+            node->flags |= CountedRegion;
+        node->basetrait = NULL;
+    }
+}
+
+// Is this type a pointer (what alloc returns and free and realloc take)?
+static int regionIsPtr(INode *type) {
+    return type && itypeGetTypeDcl(type)->tag == PtrTag;
+}
+
+// Is this type usize (the size of the value being allocated)?
+static int regionIsUsize(INode *type) {
+    return type && itypeGetTypeDcl(type) == (INode*)usizeType;
+}
+
+// Check an allocation method's signature: its parameters and (if any) its return type
+static void regionCheckFn(StructNode *node, Name *name, int required, int ptrparm, int sizeparm, int retptr) {
+    FnDclNode *fn = regionFindFn((INode*)node, name);
+    if (fn == NULL) {
+        if (required)
+            errorMsgNode((INode*)node, ErrorNoMeth, "This region must implement the %s method", &name->namestr);
+        return;
+    }
+    FnSigNode *sig = (FnSigNode*)fn->vtype;
+    Nodes *parms = sig->parms;
+    int nparms = ptrparm + sizeparm;
+    int ok = parms->used == nparms
+        && (!ptrparm || regionIsPtr(((IExpNode*)nodesGet(parms, 0))->vtype))
+        && (!sizeparm || regionIsUsize(((IExpNode*)nodesGet(parms, nparms - 1))->vtype))
+        && (retptr ? regionIsPtr(sig->rettype) : itypeGetTypeDcl(sig->rettype)->tag == VoidTag);
+    if (!ok)
+        errorMsgNode((INode*)fn, ErrorInvType, "A region's %s method must be declared as: fn %s",
+            &name->namestr,
+            name == allocName ? "alloc(size usize) *T" :
+            name == freeName ? "free(p *T)" : "realloc(p *T, size usize) *T");
+    if (fn->nextnode)
+        errorMsgNode((INode*)fn->nextnode, ErrorDupName, "A region's %s method may not be overloaded", &name->namestr);
+}
+
+// Type check a declared region, and that its allocation methods have the expected signatures
+void regionTypeCheck(TypeCheckState *pstate, StructNode *node) {
+    structTypeCheck(pstate, node);
+    if (node->fields.used > 0)
+        errorMsgNode((INode*)node, ErrorBadMeth, "A region has no instances, and so may not declare fields");
+    regionCheckFn(node, allocName, 1, 0, 1, 1);
+    regionCheckFn(node, freeName, node->flags & CountedRegion, 1, 0, 0);
+    regionCheckFn(node, reallocName, 0, 1, 1, 1);
+}
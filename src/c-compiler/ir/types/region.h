@@ -0,0 +1,46 @@
+/** Handling for regions (allocators)
+ *
+ * The built-in regions (so, rc, arena, pool) are bare AllocNodes, which the
+ * generator knows how to allocate from. A region declared with `region` is a
+ * StructNode whose static methods allocate and free its references' memory:
+ * - `fn alloc(size usize) *T` is required.
+ * - `fn free(p *T)`, if present, makes the region's references owners,
+ *   as with so: each is freed when it is dropped. Without it, the region's
+ *   references are never freed one at a time, as with arena.
+ * - `fn realloc(p *T, size usize) *T` is optional, and is checked for
+ *   use by growable allocations.
+ * A region declared as `region Name: rc` counts its references, as rc does.
+ * Its alloc and free get and release each value along with its counter,
+ * and so it must implement free.
+ * Within a region's methods, a bare name like `free` is the region's own
+ * method, so a global of the same name must be called as `::free`.
+ *
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#ifndef region_h
+#define region_h
+
+typedef struct AllocNode {
+    INsTypeNodeHdr;
+} AllocNode;
+
+// Does dropping a reference of this region free what it refers to? (so, pool, or a region with free)
+int regionFrees(INode *region);
+
+// Are this region's references reference counted? (rc, or a region declared on rc)
+int regionCounts(INode *region);
+
+// Return a declared region's alloc, free or realloc method (NULL if it has none, as built-in regions do)
+FnDclNode *regionFindFn(INode *region, Name *name);
+
+// Name resolution of a declared region, done once at its declaration
+void regionNameRes(NameResState *pstate, StructNode *node);
+
+// Type check a declared region, and that its allocation methods have the expected signatures
+void regionTypeCheck(TypeCheckState *pstate, StructNode *node);
+
+#endif
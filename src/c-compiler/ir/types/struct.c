@@ -48,6 +48,7 @@ INode *cloneStructNode(CloneState *cstate, StructNode *node) {
     }
     newnodesp = (INode**)memAllocBlk(node->nodelist.avail * sizeof(INode *));
     newnode->nodelist.nodes = newnodesp;
+    newnode->nodelist.used = 0;     // iNsTypeAddFn re-adds each method clone
     for (nodelistFor(&node->nodelist, cnt, nodesp)) {
         iNsTypeAddFn((INsTypeNode*)newnode, (FnDclNode*)(*newnodesp++ = cloneNode(cstate, *nodesp)));
     }
@@ -11,11 +11,22 @@
 TTupleNode *newTTupleNode(int cnt) {
     TTupleNode *tuple;
     newNode(tuple, TTupleNode, TTupleTag);
-    tuple->vtype = unknownType;
+    tuple->llvmtype = NULL;
+    tuple->interned = NULL;
     tuple->types = newNodes(cnt);
     return tuple;
 }
 
+// Clone type tuple
+INode *cloneTTupleNode(CloneState *cstate, TTupleNode *node) {
+    TTupleNode *newnode;
+    newnode = memAllocBlk(sizeof(TTupleNode));
+    memcpy(newnode, node, sizeof(TTupleNode));
+    newnode->flags &= ~(InternedType | InternedUse);
+    newnode->types = cloneNodes(cstate, node->types);
+    return (INode *)newnode;
+}
+
 // Serialize a type tuple node
 void ttuplePrint(TTupleNode *tuple) {
     INode **nodesp;
@@ -43,3 +54,20 @@ void ttupleTypeCheck(TypeCheckState *pstate, TTupleNode *tuple) {
     for (nodesFor(tuple->types, cnt, nodesp))
         itypeTypeCheck(pstate, nodesp);
 }
+
+// Compare two type tuples to see if they are equivalent
+int ttupleEqual(TTupleNode *node1, TTupleNode *node2) {
+    INode **nodes1p, **nodes2p;
+    uint32_t cnt;
+
+    if (node1->types->used != node2->types->used)
+        return 0;
+
+    // Every type must also match
+    nodes2p = &nodesGet(node2->types, 0);
+    for (nodesFor(node1->types, cnt, nodes1p)) {
+        if (!itypeIsSame(*nodes1p, *nodes2p++))
+            return 0;
+    }
+    return 1;
+}
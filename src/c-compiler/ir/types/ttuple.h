@@ -12,13 +12,17 @@
 // It acts like an ad hoc struct, briefly binding together types
 // for a parallel assignment or multiple return values
 typedef struct TTupleNode {
-    IExpNodeHdr;
+    ITypeNodeHdr;
     Nodes *types;
+    INode *interned;  // Interned instance of this type, if another node (see InternedUse)
 } TTupleNode;
 
 // Create a new type tuple node
 TTupleNode *newTTupleNode(int cnt);
 
+// Clone type tuple
+INode *cloneTTupleNode(CloneState *cstate, TTupleNode *node);
+
 // Serialize a type tuple node
 void ttuplePrint(TTupleNode *tuple);
 
@@ -28,4 +32,7 @@ void ttupleNameRes(NameResState *pstate, TTupleNode *node);
 // Type check type tuple node
 void ttupleTypeCheck(TypeCheckState *pstate, TTupleNode *node);
 
+// Compare two type tuples to see if they are equivalent
+int ttupleEqual(TTupleNode *node1, TTupleNode *node2);
+
 #endif
\ No newline at end of file
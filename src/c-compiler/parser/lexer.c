@@ -22,9 +22,100 @@
 #include <ctype.h>
 #include <stdio.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // Global lexer state
 Lexer *lex = NULL;        // Current lexer
 
+// All source files, in order of their (ascending) source locations
+SrcFile **lexSrcFiles = NULL;
+uint32_t lexSrcFilesCnt = 0;
+uint32_t lexSrcFilesSize = 0;
+uint32_t lexNextSrcloc = 0;     // First source location not yet given to a file
+
+// Register a new source file, giving its text the next range of source locations
+SrcFile *lexAddSrcFile(char *url, char *src) {
+    size_t srclen = strlen(src) + 1;  // Include terminator, for end-of-file tokens
+    if (srclen > UINT32_MAX - lexNextSrcloc)
+        errorExit(ExitMem, "Source files are too large to compile together");
+
+    SrcFile *srcfile = (SrcFile*) memAllocBlk(sizeof(SrcFile));
+    srcfile->url = url;
+    srcfile->fname = fileName(url);
+    srcfile->source = src;
+    srcfile->lines = NULL;
+    srcfile->nlines = 0;
+    srcfile->srcloc = lexNextSrcloc;
+    lexNextSrcloc += (uint32_t)srclen;
+
+    if (lexSrcFilesCnt == lexSrcFilesSize) {
+        SrcFile **oldfiles = lexSrcFiles;
+        lexSrcFilesSize = lexSrcFilesSize == 0 ? 16 : lexSrcFilesSize << 1;
+        lexSrcFiles = (SrcFile**) memAllocBlk(lexSrcFilesSize * sizeof(SrcFile*));
+        if (oldfiles)
+            memcpy(lexSrcFiles, oldfiles, lexSrcFilesCnt * sizeof(SrcFile*));
+    }
+    lexSrcFiles[lexSrcFilesCnt++] = srcfile;
+    return srcfile;
+}
+
+// Return the source file that a source location belongs to
+SrcFile *lexSrcFile(uint32_t srcloc) {
+    uint32_t low = 0;
+    uint32_t high = lexSrcFilesCnt;
+    while (high - low > 1) {
+        uint32_t mid = (low + high) >> 1;
+        if (lexSrcFiles[mid]->srcloc <= srcloc)
+            low = mid;
+        else
+            high = mid;
+    }
+    return lexSrcFiles[low];
+}
+
+// Build the table of where each of a source file's lines starts
+void lexBuildLines(SrcFile *srcfile) {
+    char *srcp;
+    uint32_t nlines = 1;
+    for (srcp = srcfile->source; *srcp; ++srcp) {
+        if (*srcp == '\n')
+            ++nlines;
+    }
+    uint32_t *linesp = srcfile->lines = (uint32_t*) memAllocBlk(nlines * sizeof(uint32_t));
+    *linesp++ = 0;
+    for (srcp = srcfile->source; *srcp; ++srcp) {
+        if (*srcp == '\n')
+            *linesp++ = (uint32_t)(srcp + 1 - srcfile->source);
+    }
+    srcfile->nlines = nlines;
+}
+
+// Expand a source location into its file, line number and token/line position
+void lexSrcPos(uint32_t srcloc, SrcPos *pos) {
+    SrcFile *srcfile = pos->file = lexSrcFile(srcloc);
+    if (srcfile->nlines == 0)
+        lexBuildLines(srcfile);
+
+    // Find the last line starting at or before the location
+    uint32_t offset = srcloc - srcfile->srcloc;
+    uint32_t low = 0;
+    uint32_t high = srcfile->nlines;
+    while (high - low > 1) {
+        uint32_t mid = (low + high) >> 1;
+        if (srcfile->lines[mid] <= offset)
+            low = mid;
+        else
+            high = mid;
+    }
+    pos->srcp = srcfile->source + offset;
+    pos->linep = srcfile->source + srcfile->lines[low];
+    pos->linenbr = low + 1;
+}
+
 // Inject a new source stream into the lexer
 void lexInject(char *url, char *src) {
     Lexer *prev;
@@ -50,6 +141,7 @@ void lexInject(char *url, char *src) {
     lex->url = url;
     lex->fname = fileName(url);
     lex->source = src;
+    lex->srcfile = lexAddSrcFile(url, src);
 
     // Initialize lexer context
     lex->srcp = lex->tokp = lex->linep = src;
@@ -125,17 +217,24 @@ void lexInit() {
     keywordInit();
 }
 
-// Inject a new source stream into the lexer
-void lexInjectFile(char *url) {
+// Load a source file, relative to the current one, and return its text.
+// fn is set to the source file's full path.
+char *lexLoadFile(char *url, char **fn) {
     char *src;
-    char *fn;
     timerBegin(LoadTimer);
     // Load specified source file
-    src = fileLoadSrc(lex? lex->url : NULL, url, &fn);
+    src = fileLoadSrc(lex? lex->url : NULL, url, fn);
     if (!src)
         errorExit(ExitNF, "Cannot find or read source file %s", url);
 
     timerBegin(ParseTimer);
+    return src;
+}
+
+// Inject a new source stream into the lexer
+void lexInjectFile(char *url) {
+    char *fn;
+    char *src = lexLoadFile(url, &fn);
     lexInject(fn, src);
 }
 
@@ -145,6 +244,127 @@ void lexPop() {
         lex = lex->prev;
 }
 
+// Scanners for the lexer's hot loops: runs of blanks, line comments,
+// identifiers and string literal bodies. Each returns a pointer to the first
+// byte at or after srcp that ends the run. The source's 0 terminator always ends it.
+//
+// With SSE2 or AVX2, they test a whole block of bytes at once.
+// Blocks are aligned loads, which cannot cross into another page,
+// so reading a block that extends past the terminator is harmless.
+// The address sanitizer does not know that, so it is turned off for them.
+#if defined(__AVX2__) || defined(__SSE2__)
+
+#if defined(__AVX2__)
+#define LexVecSize 32
+typedef __m256i LexVec;
+#define lexVecLoad(p) _mm256_load_si256((const LexVec *)(p))
+#define lexVecSet(ch) _mm256_set1_epi8(ch)
+#define lexVecEq(a, b) _mm256_cmpeq_epi8(a, b)
+#define lexVecGt(a, b) _mm256_cmpgt_epi8(a, b)
+#define lexVecOr(a, b) _mm256_or_si256(a, b)
+#define lexVecAnd(a, b) _mm256_and_si256(a, b)
+#define lexVecMask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#define LexVecAllBits 0xFFFFFFFFu
+#else
+#define LexVecSize 16
+typedef __m128i LexVec;
+#define lexVecLoad(p) _mm_load_si128((const LexVec *)(p))
+#define lexVecSet(ch) _mm_set1_epi8(ch)
+#define lexVecEq(a, b) _mm_cmpeq_epi8(a, b)
+#define lexVecGt(a, b) _mm_cmpgt_epi8(a, b)
+#define lexVecOr(a, b) _mm_or_si128(a, b)
+#define lexVecAnd(a, b) _mm_and_si128(a, b)
+#define lexVecMask(v) ((uint32_t)_mm_movemask_epi8(v))
+#define LexVecAllBits 0xFFFFu
+#endif
+
+#if defined(__clang__) || defined(__GNUC__)
+#define LexNoAsan __attribute__((no_sanitize_address))
+#else
+#define LexNoAsan
+#endif
+
+// Mask of the bytes in block that are in the (ASCII) range lo..hi
+#define lexVecInRange(block, lo, hi) \
+    lexVecAnd(lexVecGt(block, lexVecSet((lo) - 1)), lexVecGt(lexVecSet((hi) + 1), block))
+
+// Scan aligned blocks from srcp, until lexStops(block) finds a byte that ends the run
+#define lexVecScan(srcp, lexStops) { \
+    char *blockp = (char *)((uintptr_t)(srcp) & ~(uintptr_t)(LexVecSize - 1)); \
+    uint32_t stops = lexStops(lexVecLoad(blockp)) & (LexVecAllBits << ((srcp) - blockp)); \
+    while (stops == 0) { \
+        blockp += LexVecSize; \
+        stops = lexStops(lexVecLoad(blockp)); \
+    } \
+    return blockp + __builtin_ctz(stops); \
+}
+
+#define lexBlankStops(block) \
+    (~lexVecMask(lexVecOr(lexVecEq(block, lexVecSet(' ')), lexVecEq(block, lexVecSet('\t')))) & LexVecAllBits)
+#define lexLineEndStops(block) \
+    lexVecMask(lexVecOr(lexVecOr(lexVecEq(block, lexVecSet('\n')), lexVecEq(block, lexVecSet('\x1a'))), \
+        lexVecEq(block, lexVecSet('\0'))))
+#define lexIdentStops(block) \
+    (~lexVecMask(lexVecOr(lexVecOr(lexVecInRange(lexVecOr(block, lexVecSet(0x20)), 'a', 'z'), \
+        lexVecInRange(block, '0', '9')), lexVecEq(block, lexVecSet('_')))) & LexVecAllBits)
+// Stop at '"', '\', 0 or any byte >= 0x80 (the sign bit)
+#define lexStringStops(block) \
+    (lexVecMask(lexVecOr(lexVecOr(lexVecEq(block, lexVecSet('"')), lexVecEq(block, lexVecSet('\\'))), \
+        lexVecEq(block, lexVecSet('\0')))) | lexVecMask(block))
+
+// Skip past spaces and tabs
+LexNoAsan char *lexSkipBlanks(char *srcp) {
+    lexVecScan(srcp, lexBlankStops);
+}
+
+// Find the end of the line: new line, end-of-file or 0
+LexNoAsan char *lexFindLineEnd(char *srcp) {
+    lexVecScan(srcp, lexLineEndStops);
+}
+
+// Find the end of an identifier's ASCII letters, digits and underscores
+LexNoAsan char *lexFindIdentEnd(char *srcp) {
+    lexVecScan(srcp, lexIdentStops);
+}
+
+// Find the end of a string literal's plain ASCII characters
+LexNoAsan char *lexFindStringStop(char *srcp) {
+    lexVecScan(srcp, lexStringStops);
+}
+
+#else
+
+// Skip past spaces and tabs
+char *lexSkipBlanks(char *srcp) {
+    while (*srcp == ' ' || *srcp == '\t')
+        ++srcp;
+    return srcp;
+}
+
+// Find the end of the line: new line, end-of-file or 0
+char *lexFindLineEnd(char *srcp) {
+    while (*srcp && *srcp != '\n' && *srcp != '\x1a')
+        ++srcp;
+    return srcp;
+}
+
+// Find the end of an identifier's ASCII letters, digits and underscores
+char *lexFindIdentEnd(char *srcp) {
+    while ((*srcp >= 'a' && *srcp <= 'z') || (*srcp >= 'A' && *srcp <= 'Z')
+        || (*srcp >= '0' && *srcp <= '9') || *srcp == '_')
+        ++srcp;
+    return srcp;
+}
+
+// Find the end of a string literal's plain ASCII characters
+char *lexFindStringStop(char *srcp) {
+    while (*srcp && !(*srcp & 0x80) && *srcp != '"' && *srcp != '\\')
+        ++srcp;
+    return srcp;
+}
+
+#endif
+
 /** Return value of hex digit, or -1 if not correct */
 char *lexHexDigits(int cnt, char *srcp, uint64_t *val) {
     *val = 0;
@@ -248,15 +468,15 @@ void lexScanString(char *srcp) {
     lex->tokp = srcp++;
 
     // Conservatively count the size of the string
-    uint32_t srclen = 0;
-    while (*srcp && *srcp != '"') {
-        srclen++;
-        srcp++;
-        if (*srcp == '\\' && *(srcp + 1) == '"') {
-            srclen++;
-            srcp += 2;
-        }
+    // (no escape sequence builds more bytes than it takes up in source)
+    char *endp = srcp;
+    while (1) {
+        endp = lexFindStringStop(endp);
+        if (*endp == '"' || *endp == '\0')
+            break;
+        endp += (*endp == '\\' && *(endp + 1)) ? 2 : 1;
     }
+    uint32_t srclen = (uint32_t)(endp - srcp);
 
     // Build string literal
     char *newp = memAllocStr(NULL, srclen);
@@ -264,6 +484,15 @@ void lexScanString(char *srcp) {
     lex->val.strlit = newp;
     srcp = lex->tokp+1;
     while (*srcp != '"') {
+        // Copy over a run of plain ASCII characters all at once
+        char *runend = lexFindStringStop(srcp);
+        if (runend > srcp) {
+            memcpy(newp, srcp, runend - srcp);
+            newp += runend - srcp;
+            srclen += (uint32_t)(runend - srcp);
+            srcp = runend;
+            continue;
+        }
         if (*srcp == '\\')
             srcp = lexScanEscape(srcp, &uchar);
         else
@@ -415,47 +644,30 @@ void lexScanNumber(char *srcp) {
 void lexScanIdent(char *srcp) {
     char *srcbeg = srcp++;    // Pointer to the start of the token
     lex->tokp = srcbeg;
-    while (1) {
-        switch (*srcp) {
 
+    // Find the end of the identifier
+    while (1) {
         // Allow digit, letter or underscore in token
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-        case 'a': case 'b': case 'c': case 'd': case 'e':
-        case 'f': case 'g': case 'h': case 'i': case 'j':
-        case 'k': case 'l': case 'm': case 'n': case 'o':
-        case 'p': case 'q': case 'r': case 's': case 't':
-        case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
-        case 'A': case 'B': case 'C': case 'D': case 'E':
-        case 'F': case 'G': case 'H': case 'I': case 'J':
-        case 'K': case 'L': case 'M': case 'N': case 'O':
-        case 'P': case 'Q': case 'R': case 'S': case 'T':
-        case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
-        case '_':
-            srcp++;
-            break;
+        srcp = lexFindIdentEnd(srcp);
 
-        default:
-            // Allow unicode letters in identifier name
-            if (utf8IsLetter(srcp))
-                srcp += utf8ByteSkip(srcp);
-            else {
-                INode *identNode;
-                // Find identifier token in name table and preserve info about it
-                // Substitute token type when identifier is a keyword
-                lex->val.ident = nametblFind(srcbeg, srcp-srcbeg);
-                identNode = (INode*)lex->val.ident->node;
-                if (identNode && identNode->tag == KeywordTag)
-                    lex->toktype = identNode->flags;
-                else if (identNode && identNode->tag == PermTag)
-                    lex->toktype = PermToken;
-                else
-                    lex->toktype = IdentToken;
-                lex->srcp = srcp;
-                return;
-            }
-        }
+        // Allow unicode letters in identifier name
+        if (!utf8IsLetter(srcp))
+            break;
+        srcp += utf8ByteSkip(srcp);
     }
+
+    // Find identifier token in name table and preserve info about it
+    // Substitute token type when identifier is a keyword
+    INode *identNode;
+    lex->val.ident = nametblFind(srcbeg, srcp-srcbeg);
+    identNode = (INode*)lex->val.ident->node;
+    if (identNode && identNode->tag == KeywordTag)
+        lex->toktype = identNode->flags;
+    else if (identNode && identNode->tag == PermTag)
+        lex->toktype = PermToken;
+    else
+        lex->toktype = IdentToken;
+    lex->srcp = srcp;
 }
 
 /** Tokenize an identifier or reserved token */
@@ -758,9 +970,7 @@ void lexNextTokenx() {
         case '/':
             // Line comment: '//'
             if (*(srcp+1)=='/') {
-                srcp += 2;
-                while (*srcp && *srcp!='\n' && *srcp!='\x1a')
-                    srcp++;
+                srcp = lexFindLineEnd(srcp + 2);
             }
             // Block comment, nested: '/*'
             else if (*(srcp + 1) == '*') {
@@ -776,7 +986,7 @@ void lexNextTokenx() {
 
         // Ignore white space
         case ' ': case '\t':
-            srcp++;
+            srcp = lexSkipBlanks(srcp + 1);
             break;
 
         // Ignore carriage return
@@ -789,8 +999,7 @@ void lexNextTokenx() {
             ++srcp;
             if (lex->nbrcurly == 0) {
                 // Skip to end of line
-                while (*srcp && *srcp != '\n' && *srcp != '\x1a')
-                    srcp++;
+                srcp = lexFindLineEnd(srcp);
                 // Skip over new line
                 if (*srcp == '\n') {
                     srcp++;
@@ -15,6 +15,26 @@ typedef struct Name Name;    // ../ast/nametbl.h
 
 #define LEX_MAX_INDENTS 1024
 
+// Source file info, kept for expanding the source locations of nodes.
+// Every source file's text occupies its own range of a single 32-bit source
+// location space, starting at srcloc. So a node's location is just a number.
+typedef struct SrcFile {
+    char *url;          // The url where the source text came from
+    char *fname;        // The filename of the url (no extension)
+    char *source;       // The source text (0-terminated)
+    uint32_t *lines;    // Offset of the start of each line (built lazily)
+    uint32_t nlines;    // Number of lines in the table (0 until built)
+    uint32_t srcloc;    // Source location of the source text's first character
+} SrcFile;
+
+// A source location expanded into where it is in its source file
+typedef struct SrcPos {
+    SrcFile *file;      // -> url (filepath) and -> source
+    char *srcp;         // Start of source token
+    char *linep;        // Start of the line that token begins on
+    uint32_t linenbr;   // Source file's line number, starting with 1
+} SrcPos;
+
 // Lexer state (one per source file)
 typedef struct Lexer {
     // Value info about a discovered token
@@ -30,6 +50,7 @@ typedef struct Lexer {
     char *url;        // The url where the source text came from
     char *fname;    // The filename of the url (no extension)
     char *source;    // The source text (0-terminated)
+    SrcFile *srcfile;   // Source file info for source locations
 
     struct Lexer *next;    // Next lexer (linked list of injected lexers)
     struct Lexer *prev; // Previous lexer
@@ -157,12 +178,22 @@ Lexer *lex;
 
 #define lexIsToken(tok) (lex->toktype == (tok))
 
+// Source location of the current token
+#define lexTokSrcloc() (lex->srcfile->srcloc + (uint32_t)(lex->tokp - lex->source))
+
 // Lexer functions
 void lexInit();
+char *lexLoadFile(char *url, char **fn);
 void lexInjectFile(char *url);
 void lexInject(char *url, char *src);
 void lexPop();
 void lexNextToken();
 int lexIsEndOfStatement();
 
+// Return the source file that a source location belongs to
+SrcFile *lexSrcFile(uint32_t srcloc);
+
+// Expand a source location into its file, line number and token/line position
+void lexSrcPos(uint32_t srcloc, SrcPos *pos);
+
 #endif
@@ -136,31 +136,135 @@ char *parseFile() {
 
 void parseGlobalStmts(ParseState *parse, ModuleNode *mod);
 
+// The include cache lets a file included into several modules be lexed and parsed once.
+// An entry is keyed by the file's resolved path and a hash of its source text.
+// It remembers the top-level nodes that the file's first parse added to its module.
+// Later includes of the file clone those nodes into their own module.
+typedef struct IncludeCache {
+    struct IncludeCache *next;
+    char *url;              // Resolved path of the included source file
+    size_t hash;            // Hash of its source text
+    ModuleNode *mod;        // Module the file was first parsed into
+    Nodes *nodes;           // Top-level nodes parsed from it (NULL if they cannot be reused)
+} IncludeCache;
+
+IncludeCache *parseIncludes = NULL;
+
+// Return 1 if a parsed top-level node may be cloned into another module.
+// Modules, typedefs, macros and generics are not (yet) clonable.
+int parseIsReusable(INode *node) {
+    switch (node->tag) {
+    case FnDclTag:
+        return ((FnDclNode*)node)->namesym != NULL;  // Not an anonymous function
+    case VarDclTag:
+    case StructTag:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// Clone an included file's cached top-level nodes into the current module,
+// giving functions and variables the linker names this module would have given them.
+void parseIncludeClone(ParseState *parse, IncludeCache *inc) {
+    INode **nodesp;
+    uint32_t cnt;
+
+    // Module-relative name qualifiers are mapped to this module
+    CloneState cstate;
+    uint32_t dclpos = cloneDclPush();
+    clonePushState(&cstate, NULL, NULL, 0, NULL, NULL);
+    cloneDclSetMap((INode*)inc->mod, (INode*)parse->mod);
+    Nodes *clones = cloneNodes(&cstate, inc->nodes);
+    clonePopState();
+    cloneDclPop(dclpos);
+
+    for (nodesFor(clones, cnt, nodesp)) {
+        if ((*nodesp)->tag == StructTag) {
+            StructNode *strnode = (StructNode*)*nodesp;
+            char *prefix = parse->gennamePrefix;
+            INode **methp;
+            uint32_t methcnt;
+            strnode->mod = parse->mod;
+            nameConcatPrefix(&prefix, &strnode->namesym->namestr);
+            for (nodelistFor(&strnode->nodelist, methcnt, methp)) {
+                FnDclNode *meth = (FnDclNode*)*methp;
+                meth->genname = &meth->namesym->namestr;
+                nameGenFnName(meth, prefix);
+            }
+            modAddNode(parse->mod, strnode->namesym, (INode*)strnode);
+        }
+        else {
+            VarDclNode *node = (VarDclNode*)*nodesp;
+            node->genname = &node->namesym->namestr;
+            nameGenVarName(node, parse->gennamePrefix);
+            modAddNode(parse->mod, node->namesym, (INode*)node);
+        }
+    }
+}
+
 // Parse include statement
 void parseInclude(ParseState *parse) {
-    char *filename;
+    char *filename, *fn, *src;
     lexNextToken();
     filename = parseFile();
     parseEndOfStatement();
 
-    lexInjectFile(filename);
+    // Clone the file's nodes, if it has been parsed before
+    src = lexLoadFile(filename, &fn);
+    size_t hash = nametblHash(src, strlen(src));
+    IncludeCache *inc;
+    for (inc = parseIncludes; inc; inc = inc->next) {
+        if (inc->hash == hash && strcmp(inc->url, fn) == 0)
+            break;
+    }
+    if (inc && inc->nodes) {
+        parseIncludeClone(parse, inc);
+        return;
+    }
+
+    uint32_t firstnode = parse->mod->nodes->used;
+    int olderrors = errors;
+    lexInject(fn, src);
     parseGlobalStmts(parse, parse->mod);
     if (lex->toktype != EofToken) {
         errorMsgLex(ErrorNoEof, "Expected end-of-file");
     }
     lexPop();
+
+    // Cache the top-level nodes it added, if they parsed cleanly and can all be cloned
+    if (inc == NULL) {
+        inc = memAllocBlk(sizeof(IncludeCache));
+        inc->url = fn;
+        inc->hash = hash;
+        inc->mod = parse->mod;
+        inc->nodes = NULL;
+        inc->next = parseIncludes;
+        parseIncludes = inc;
+        if (errors == olderrors) {
+            Nodes *modnodes = parse->mod->nodes;
+            inc->nodes = newNodes(modnodes->used - firstnode);
+            for (uint32_t i = firstnode; i < modnodes->used; ++i) {
+                if (!parseIsReusable(nodesGet(modnodes, i))) {
+                    inc->nodes = NULL;
+                    break;
+                }
+                nodesAdd(&inc->nodes, nodesGet(modnodes, i));
+            }
+        }
+    }
 }
 
 // Parse function or variable, as it may be preceded by a qualifier
 // Return NULL if not either
-void parseFnOrVar(ParseState *parse, uint16_t flags) {
+INode *parseFnOrVar(ParseState *parse, uint16_t flags) {
 
     if (lexIsToken(FnToken)) {
         FnDclNode *node = (FnDclNode*)parseFn(parse, 0, (flags&FlagExtern)? (ParseMayName | ParseMaySig) : (ParseMayName | ParseMayImpl));
         node->flags |= flags;
         nameGenVarName((VarDclNode *)node, parse->gennamePrefix);
         modAddNode(parse->mod, node->namesym, (INode*)node);
-        return;
+        return (INode*)node;
     }
 
     // A global variable declaration, if it begins with a permission
@@ -170,11 +274,12 @@ void parseFnOrVar(ParseState *parse, uint16_t flags) {
         parseEndOfStatement();
         nameGenVarName((VarDclNode *)node, parse->gennamePrefix);
         modAddNode(parse->mod, node->namesym, (INode*)node);
+        return (INode*)node;
     }
     else {
         errorMsgLex(ErrorBadGloStmt, "Expected function or variable declaration");
         parseSkipToNextStmt();
-        return;
+        return NULL;
     }
 }
 
@@ -213,6 +318,42 @@ GenericNode *parseMacro(ParseState *parse) {
 
 ModuleNode *parseModule(ParseState *parse);
 
+// Parse a function qualified with 'multiversion', and the feature levels to
+// compile it for as well as the target's (default "sse4.2", "avx2", "avx512f")
+static void parseMultiVersion(ParseState *parse) {
+    lexNextToken();
+    char *versions = "sse4.2,avx2,avx512f";
+    if (lexIsToken(StringLitToken)) {
+        size_t len = 0;
+        while (lexIsToken(StringLitToken)) {
+            // Each level given makes the comma-separated list longer
+            size_t add = strlen(lex->val.strlit);
+            char *more = memAllocStr(NULL, len + (len ? 1 : 0) + add);
+            if (len) {
+                memcpy(more, versions, len);
+                more[len++] = ',';
+            }
+            strcpy(more + len, lex->val.strlit);
+            versions = more;
+            len += add;
+            lexNextToken();
+            if (lexIsToken(CommaToken))
+                lexNextToken();
+        }
+    }
+    // The qualifier may be on the line before fn
+    if (lexIsToken(SemiToken))
+        lexNextToken();
+    if (!lexIsToken(FnToken)) {
+        errorMsgLex(ErrorBadGloStmt, "Expected a function after multiversion");
+        parseSkipToNextStmt();
+        return;
+    }
+    FnDclNode *fndcl = (FnDclNode*)parseFnOrVar(parse, 0);
+    if (fndcl)
+        fndcl->versions = versions;
+}
+
 // Parse a global area statement (within a module)
 // modAddNode adds node to module, as needed, including error message for dupes
 void parseGlobalStmts(ParseState *parse, ModuleNode *mod) {
@@ -243,6 +384,13 @@ void parseGlobalStmts(ParseState *parse, ModuleNode *mod) {
             break;
         }
 
+        // 'region' definition, whose methods allocate and free its references
+        case RegionToken: {
+            StructNode *strnode = (StructNode*)parseStruct(parse, 0);
+            modAddNode(mod, strnode->namesym, (INode*)strnode);
+            break;
+        }
+
         // 'trait' type definition
         case TraitToken: {
             StructNode *strnode = (StructNode*)parseStruct(parse, TraitType | OpaqueType);
@@ -292,6 +440,15 @@ void parseGlobalStmts(ParseState *parse, ModuleNode *mod) {
             parseFnOrVar(parse, 0);
             break;
 
+        // 'multiversion' qualifier in front of fn. It is not a reserved word,
+        // so it is recognized only where a global statement starts.
+        case IdentToken:
+            if (strcmp(&lex->val.ident->namestr, "multiversion") == 0) {
+                parseMultiVersion(parse);
+                break;
+            }
+            // Otherwise, fall through to the error
+
         default:
             errorMsgLex(ErrorBadGloStmt, "Invalid global area statement");
             lexNextToken();
@@ -344,8 +501,9 @@ ModuleNode *parseModule(ParseState *parse) {
     return mod;
 }
 
-// Parse a program = the main module
-ModuleNode *parsePgm(ConeOptions *opt) {
+// Parse the core library, whose names are shared by all modules.
+// This starts the name table and lexer afresh.
+ModuleNode *parseCorelib(ConeOptions *opt) {
     // Initialize name table and lexer
     nametblInit();
     lexInit();
@@ -363,6 +521,20 @@ ModuleNode *parsePgm(ConeOptions *opt) {
     parse.pgmmod = coremod;
     lexInject("corelib", stdlibInit(opt->ptrsize));
     parseGlobalStmts(&parse, coremod);
+    return coremod;
+}
+
+// Parse a program = the main module.
+// coremod is the core library, if already parsed (e.g., by a compile server), or NULL.
+ModuleNode *parsePgm(ConeOptions *opt, ModuleNode *coremod) {
+    if (!coremod)
+        coremod = parseCorelib(opt);
+
+    // Initialize parser state
+    ParseState parse;
+    parse.mod = NULL;
+    parse.typenode = NULL;
+    parse.gennamePrefix = "";
 
     // Parse main source file
     ModuleNode *mod = newModuleNode();
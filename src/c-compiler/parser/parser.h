@@ -28,7 +28,8 @@ enum ParseFlags {
 };
 
 // parser.c
-ModuleNode *parsePgm(ConeOptions *opt);
+ModuleNode *parseCorelib(ConeOptions *opt);
+ModuleNode *parsePgm(ConeOptions *opt, ModuleNode *coremod);
 ModuleNode *parseModuleBlk(ParseState *parse, ModuleNode *mod);
 INode *parseFn(ParseState *parse, uint16_t nodeflags, uint16_t mayflags);
 void parseEndOfStatement();
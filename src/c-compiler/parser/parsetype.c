@@ -145,7 +145,7 @@ INode *parseStruct(ParseState *parse, uint16_t strflags) {
     uint16_t fieldnbr = 0;
 
     // Capture the kind of type, then get next token (name)
-    uint16_t tag = StructTag;
+    uint16_t tag = lexIsToken(RegionToken) ? RegionTag : StructTag;
     lexNextToken();
 
     // Process struct type name, if provided
@@ -252,6 +252,9 @@ INode *parseFnSig(ParseState *parse) {
     uint16_t parmnbr = 0;
     uint16_t parseflags = ParseMaySig | ParseMayImpl;
 
+    // A type's methods take self, except a region's: a region has no instances
+    int hasself = parse->typenode && parse->typenode->tag != RegionTag;
+
     // Set up memory block for the function's type signature
     fnsig = newFnSigNode();
 
@@ -259,12 +262,12 @@ INode *parseFnSig(ParseState *parse) {
     if (lexIsToken(LParenToken)) {
         lexNextToken();
         // A type's method with no parameters should still define self
-        if (lexIsToken(RParenToken) && parse->typenode)
+        if (lexIsToken(RParenToken) && hasself)
             parseInjectSelf(fnsig);
         while (lexIsToken(PermToken) || lexIsToken(IdentToken)) {
             VarDclNode *parm = parseVarDcl(parse, immPerm, parseflags);
             // Do special inference if function is a type's method
-            if (parse->typenode) {
+            if (hasself) {
                 // Create default self parm, if 'self' was not specified
                 if (parmnbr == 0 && parm->namesym != selfName) {
                     parseInjectSelf(fnsig);
@@ -78,8 +78,10 @@ void errorOutCode(char *tokp, uint32_t linenbr, char *linep, char *url, int code
 // Send an error message to stderr
 void errorMsgNode(INode *node, int code, const char *msg, ...) {
     va_list argptr;
+    SrcPos pos;
+    lexSrcPos(node->srcloc, &pos);
     va_start(argptr, msg);
-    errorOutCode(node->srcp, node->linenbr, node->linep, node->lexer->url, code, msg, argptr);
+    errorOutCode(pos.srcp, pos.linenbr, pos.linep, pos.file->url, code, msg, argptr);
     va_end(argptr);
     if (node->instnode)
         errorMsgNode(node->instnode, Uncounted, "... as instantiated by this part of the source code");
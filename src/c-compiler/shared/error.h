@@ -79,6 +79,7 @@ enum ErrorCode {
     WarnIndent,        // Inconsistent indent character
     WarnCopy,       // Unsafe attempt to copy a CopyMethod or CopyMove typed value
     WarnLoop,       // Infinite loop with no break
+    WarnSelfCall,   // A region's method calls itself by its bare name
 
     // Uncounted
     Uncounted = 9000,
@@ -12,6 +12,83 @@
 #include <string.h>
 #include <stddef.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define FileMapping
+#endif
+
+// Files at least this big are memory-mapped rather than read into the string arena
+size_t gFileMapMin = 4 * 4096;
+
+#ifdef FileMapping
+/** Map a file's contents read-only, followed by at least one 0 byte, or return NULL.
+ * The mapping is padded out to one byte past the file's end, rounded up to a page.
+ * Anonymous (zeroed) pages are reserved for its whole length, and the file is mapped
+ * over the front of them. The bytes past the end of the file in its last page are
+ * zero as well, so the source is always 0-terminated, even if its size is a
+ * multiple of the page size. The mapping lasts as long as the compiler runs. */
+char *fileMap(int fd, size_t filesize) {
+    size_t pagesize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t maplen = (filesize + pagesize) & ~(pagesize - 1);
+    char *filestr = mmap(NULL, maplen, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (filestr == MAP_FAILED)
+        return NULL;
+    int flags = MAP_PRIVATE | MAP_FIXED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;      // Fill in page tables now, rather than fault on every page
+#endif
+    if (mmap(filestr, filesize, PROT_READ, flags, fd, 0) == MAP_FAILED) {
+        munmap(filestr, maplen);
+        return NULL;
+    }
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise(filestr, filesize, POSIX_MADV_SEQUENTIAL);
+#endif
+    return filestr;
+}
+
+/** Load a file into an allocated (or mapped) string, return pointer or NULL if not found.
+ * The lexer only reads its source, so a large file is mapped rather than copied. */
+char *fileLoad(char *fn) {
+    int fd;
+    struct stat filestat;
+    size_t filesize;
+    char *filestr;
+
+    // Open the file - return null on failure
+    if ((fd = open(fn, O_RDONLY)) < 0)
+        return NULL;
+    if (fstat(fd, &filestat) < 0) {
+        close(fd);
+        return NULL;
+    }
+    filesize = (size_t)filestat.st_size;
+
+    // Map a large regular file. The mapping outlives the file descriptor.
+    if (S_ISREG(filestat.st_mode) && filesize >= gFileMapMin
+        && (filestr = fileMap(fd, filesize))) {
+        close(fd);
+        return filestr;
+    }
+
+    // Otherwise, read the data into an allocated string buffer and close file
+    filestr = memAllocStr(NULL, filesize);
+    size_t filepos = 0;
+    while (filepos < filesize) {
+        ssize_t got = read(fd, filestr + filepos, filesize - filepos);
+        if (got <= 0)
+            break;
+        filepos += got;
+    }
+    filestr[filepos]='\0';
+    close(fd);
+    return filestr;
+}
+
+#else
 /** Load a file into an allocated string, return pointer or NULL if not found */
 char *fileLoad(char *fn) {
     FILE *file;
@@ -34,6 +111,7 @@ char *fileLoad(char *fn) {
     fclose(file);
     return filestr;
 }
+#endif
 
 /** Extract a filename only (no extension) from a path */
 char *fileName(char *fn) {
@@ -73,6 +151,50 @@ char *fileMakePath(char *dir, char *srcfn, char *ext) {
     return outnm;
 }
 
+/** Copy a file's contents to another file (replaced if it exists). Return 0 if it fails. */
+int fileCopy(char *frompath, char *topath) {
+    char buf[16384];
+    size_t len;
+    FILE *from, *to;
+    int ok = 1;
+
+    if (!(from = fopen(frompath, "rb")))
+        return 0;
+    if (!(to = fopen(topath, "wb"))) {
+        fclose(from);
+        return 0;
+    }
+    while ((len = fread(buf, 1, sizeof(buf), from)) > 0) {
+        if (fwrite(buf, 1, len, to) != len) {
+            ok = 0;
+            break;
+        }
+    }
+    if (ferror(from))
+        ok = 0;
+    fclose(from);
+    if (fclose(to) != 0)
+        ok = 0;
+    return ok;
+}
+
+// Write a buffer as a file's whole contents (replaced if it exists), in one write.
+// Return 0 if it fails.
+int fileWrite(char *path, char *buf, size_t size) {
+    FILE *to;
+    int ok = 1;
+
+    if (!(to = fopen(path, "wb")))
+        return 0;
+    // Unbuffered, so the buffer goes straight to the file rather than in pieces
+    setvbuf(to, NULL, _IONBF, 0);
+    if (size && fwrite(buf, 1, size, to) != size)
+        ok = 0;
+    if (fclose(to) != 0)
+        ok = 0;
+    return ok;
+}
+
 // Get number of characters in string up to file name
 size_t fileFolder(char *fn) {
     char *fnp = &fn[strlen(fn) - 1];
@@ -8,7 +8,13 @@
 #ifndef fileio_h
 #define fileio_h
 
+#include <stddef.h>
+
+// Files at least this big are memory-mapped rather than copied (default is 4 pages)
+size_t gFileMapMin;
+
 // Load a file into an allocated string, return pointer or NULL if not found
+// The string is read-only: large files are mapped rather than read
 char *fileLoad(char *fn);
 
 // Extract a filename only (no extension) from a path
@@ -17,6 +23,13 @@ char *fileName(char *fn);
 // Concatenate folder, filename and extension into a path
 char *fileMakePath(char *dir, char *srcfn, char *ext);
 
+// Copy a file's contents to another file (replaced if it exists). Return 0 if it fails.
+int fileCopy(char *frompath, char *topath);
+
+// Write a buffer as a file's whole contents (replaced if it exists), in one write.
+// Return 0 if it fails.
+int fileWrite(char *path, char *buf, size_t size);
+
 // Create a new source file url relative to current, substituting new path and .cone extension
 char *fileSrcUrl(char *cururl, char *srcfn, int newfolder);
 
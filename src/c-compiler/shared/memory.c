@@ -3,7 +3,12 @@
  *
  * The compiler's memory management is deliberately leaky for high performance.
  * Allocation is done via bump pointer within very large arenas allocated from the heap
- * Nothing is ever freed.
+ * Nothing is ever freed, with one exception: the temporary arena.
+ *
+ * The temporary arena serves work data that only lives for part of a pass
+ * (a function's generation, a function's flow analysis, etc.). It is also bump-pointer
+ * allocated, but its chunks are chained so that memTmpRelease() can hand back
+ * everything allocated since a memTmpMark(), making that memory reusable.
  *
  * This source file is part of the Cone Programming Language C compiler
  * See Copyright Notice in conec.h
@@ -20,6 +25,7 @@
 // Public globals: Arena size configuration values
 size_t gMemBlkArenaSize = 256 * 4096;
 size_t gMemStrArenaSize = 128 * 4096;
+size_t gMemTmpArenaSize = 64 * 4096;
 
 // Private globals: memory allocation arena bookkeeping
 static void *gMemBlkArenaPos = NULL;
@@ -27,6 +33,18 @@ static size_t gMemBlkArenaLeft = 0;
 static void *gMemStrArenaPos = NULL;
 static size_t gMemStrArenaLeft = 0;
 
+// Header for a chunk in the temporary arena, chained newest first
+typedef struct MemTmpChunk {
+    struct MemTmpChunk *prev;   // Previously allocated chunk
+    size_t size;                // Usable bytes following the header
+} MemTmpChunk;
+#define MemTmpHdrSize ((sizeof(MemTmpChunk) + 15) & ~15)
+
+static MemTmpChunk *gMemTmpChunk = NULL;
+static void *gMemTmpArenaPos = NULL;
+static size_t gMemTmpArenaLeft = 0;
+static MemTmpChunk *gMemTmpSpare = NULL;   // A released chunk, kept to avoid malloc churn
+
 size_t memAllocated = 0;
 
 /** Allocate memory for a block, aligned to a 16-byte boundary */
@@ -106,8 +124,78 @@ char *memAllocStr(char *str, size_t size) {
     return (char*) strp;
 }
 
+/** Remember the current position in the temporary arena */
+MemTmpMark memTmpMark() {
+    MemTmpMark mark;
+    mark.chunk = gMemTmpChunk;
+    mark.left = gMemTmpArenaLeft;
+    return mark;
+}
+
+/** Allocate temporary memory, aligned to a 16-byte boundary.
+ * It remains valid only until the enclosing mark is released */
+void *memAllocTmp(size_t size) {
+    void *memp;
+    MemTmpChunk *chunk;
+    size_t chunksize;
+
+    // Align to 16-byte boundary
+    size = (size + 15) & ~15;
+
+    // Return next bite out of current chunk, if it fits
+    if (size <= gMemTmpArenaLeft) {
+        gMemTmpArenaLeft -= size;
+        memp = gMemTmpArenaPos;
+        gMemTmpArenaPos = (char*)gMemTmpArenaPos + size;
+        return memp;
+    }
+
+    // Chain in a new chunk: standard-sized (re-using the spare if we have one),
+    // or exactly big enough for a request too big for a standard chunk
+    chunksize = size > gMemTmpArenaSize ? size : gMemTmpArenaSize;
+    if (chunksize == gMemTmpArenaSize && gMemTmpSpare) {
+        chunk = gMemTmpSpare;
+        gMemTmpSpare = NULL;
+    }
+    else {
+        chunk = (MemTmpChunk *)malloc(MemTmpHdrSize + chunksize);
+        memAllocated += chunksize;
+        if (chunk == NULL)
+            errorExit(ExitMem, "Error: Out of memory");
+    }
+    chunk->prev = gMemTmpChunk;
+    chunk->size = chunksize;
+    gMemTmpChunk = chunk;
+
+    memp = (char*)chunk + MemTmpHdrSize;
+    gMemTmpArenaPos = (char*)memp + size;
+    gMemTmpArenaLeft = chunksize - size;
+    return memp;
+}
+
+/** Release all temporary memory allocated since mark */
+void memTmpRelease(MemTmpMark mark) {
+    // Unchain every chunk allocated after the marked one
+    while (gMemTmpChunk != mark.chunk) {
+        MemTmpChunk *chunk = gMemTmpChunk;
+        gMemTmpChunk = chunk->prev;
+        if (chunk->size == gMemTmpArenaSize && gMemTmpSpare == NULL)
+            gMemTmpSpare = chunk;
+        else {
+            memAllocated -= chunk->size;
+            free(chunk);
+        }
+    }
+
+    // Rewind bump pointer within the marked chunk
+    gMemTmpArenaLeft = mark.left;
+    gMemTmpArenaPos = gMemTmpChunk == NULL ? NULL
+        : (char*)gMemTmpChunk + MemTmpHdrSize + gMemTmpChunk->size - mark.left;
+}
+
 size_t nametblUnused();
 // Return how much memory actually needed for use
 size_t memUsed() {
-    return memAllocated - gMemBlkArenaLeft - gMemStrArenaLeft - nametblUnused();
+    return memAllocated - gMemBlkArenaLeft - gMemStrArenaLeft - gMemTmpArenaLeft
+        - (gMemTmpSpare ? gMemTmpSpare->size : 0) - nametblUnused();
 }
@@ -22,6 +22,27 @@ void *memAllocBlk(size_t size);
 // Allocates extra byte for string-ending 0, appending it to copied string
 char *memAllocStr(char *str, size_t size);
 
+// Scoped arena for temporary allocations (e.g., a pass's work arrays)
+// memTmpMark() remembers the current arena position. memTmpRelease() gives
+// back everything allocated since that mark, so marks must be released in LIFO order.
+typedef struct MemTmpMark {
+    void *chunk;     // Arena chunk that was current when marked
+    size_t left;     // Bytes that were still unused in that chunk
+} MemTmpMark;
+
+// Configurable size for temporary arena chunks
+size_t gMemTmpArenaSize;    // Default is 64 pages
+
+// Remember the current position in the temporary arena
+MemTmpMark memTmpMark();
+
+// Allocate temporary memory, aligned to a 16-byte boundary
+// It remains valid only until the enclosing mark is released
+void *memAllocTmp(size_t size);
+
+// Release all temporary memory allocated since mark
+void memTmpRelease(MemTmpMark mark);
+
 // Return memory allocated and used
 size_t memUsed();
 
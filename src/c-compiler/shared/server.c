@@ -0,0 +1,179 @@
+/** Compile server: run compiles requested over a Unix domain socket
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "server.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int serverRun(char *path, int (*compile)(int argc, char **argv)) {
+    errorExit(ExitOpts, "A compile server is not supported on Windows");
+    return ExitOpts;
+}
+
+#else
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+// Read exactly len bytes, or return 0
+static int serverRead(int fd, char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t got = read(fd, buf, len);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return 0;
+        buf += got;
+        len -= (size_t)got;
+    }
+    return 1;
+}
+
+// Receive a request's header, along with the client's stdin, stdout and stderr
+static int serverRecvHeader(int conn, ServerRequest *req, int *fds) {
+    char control[CMSG_SPACE(3 * sizeof(int))];
+    struct iovec iov = { req, sizeof(ServerRequest) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t got;
+    while ((got = recvmsg(conn, &msg, 0)) < 0 && errno == EINTR)
+        ;
+    if (got <= 0)
+        return 0;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+        || cmsg->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+        return 0;
+    memcpy(fds, CMSG_DATA(cmsg), 3 * sizeof(int));
+    // The header may arrive in pieces, after the descriptors
+    if (!serverRead(conn, (char*)req + got, sizeof(ServerRequest) - (size_t)got)) {
+        close(fds[0]); close(fds[1]); close(fds[2]);
+        return 0;
+    }
+    return 1;
+}
+
+// Handle one connection: read the request, compile it in a child process
+// with the client's working directory and stdio, and reply with its exit code
+static void serverHandle(int conn, int (*compile)(int argc, char **argv)) {
+    ServerRequest req;
+    int fds[3];
+    if (!serverRecvHeader(conn, &req, fds))
+        return;
+    if (req.magic != ServerMagic || req.argc == 0 || req.argc > ServerMaxArgs || req.size > ServerMaxSize)
+        return;
+
+    // Split the strings: the working directory, then the arguments
+    char *strs = malloc(req.size + 1);
+    char **argv = malloc((req.argc + 1) * sizeof(char*));
+    if (!strs || !argv || !serverRead(conn, strs, req.size))
+        return;
+    strs[req.size] = '\0';
+    char *strp = strs;
+    char *strend = strs + req.size;
+    char *cwd = strp;
+    uint32_t i;
+    strp += strlen(strp) + 1;
+    for (i = 0; i < req.argc; ++i) {
+        if (strp >= strend)
+            return;
+        argv[i] = strp;
+        strp += strlen(strp) + 1;
+    }
+    argv[req.argc] = NULL;
+
+    int code = ExitOpts;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(conn);
+        for (i = 0; i < 3; ++i) {
+            dup2(fds[i], i);
+            close(fds[i]);
+        }
+        if (chdir(cwd) != 0)
+            errorExit(ExitOpts, "Cannot change to directory %s", cwd);
+        exit(compile((int)req.argc, argv));
+    }
+    if (pid > 0) {
+        int status;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+            ;
+        code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
+    for (i = 0; i < 3; ++i)
+        close(fds[i]);
+    int32_t reply = code;
+    if (write(conn, &reply, sizeof(reply)) != sizeof(reply))
+        return;
+}
+
+int serverRun(char *path, int (*compile)(int argc, char **argv)) {
+    struct sockaddr_un addr;
+    int listener;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        errorExit(ExitOpts, "Server socket path is too long: %s", path);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // Replace a socket left by an earlier server, but never any other file
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode))
+            errorExit(ExitOpts, "Cannot listen on %s: it exists and is not a socket", path);
+        unlink(path);
+    }
+
+    // Only this user may connect, and so run compiles as this user
+    mode_t oldmask = umask(0177);
+    int bound = (listener = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0
+        && bind(listener, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    umask(oldmask);
+    if (!bound || listen(listener, 128) != 0)
+        errorExit(ExitOpts, "Cannot listen on %s: %s", path, strerror(errno));
+
+    // Connections are handled by children, reaped without waiting on them
+    signal(SIGCHLD, SIG_IGN);
+    for (;;) {
+        int conn = accept(listener, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            errorExit(ExitOpts, "Cannot accept on %s: %s", path, strerror(errno));
+        }
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid == 0) {
+            // This child waits on the compile, so it reaps its own
+            signal(SIGCHLD, SIG_DFL);
+            close(listener);
+            serverHandle(conn, compile);
+            _exit(0);
+        }
+        close(conn);
+    }
+    return ExitSuccess;
+}
+
+#endif
@@ -0,0 +1,38 @@
+/** Compile server: run compiles requested over a Unix domain socket
+ * @file
+ *
+ * A client connects and sends a ServerRequest header, passing its stdin,
+ * stdout and stderr file descriptors along with it (as SCM_RIGHTS). The
+ * header is followed by its working directory and then its arguments, as
+ * nul-terminated strings. When the compile is done, the server replies with
+ * its exit code, as a 4-byte int, and closes the connection.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#ifndef server_h
+#define server_h
+
+#include <stdint.h>
+
+#define ServerMagic 0x436f6e65u    // "Cone"
+#define ServerMaxArgs 1024
+#define ServerMaxSize (1u << 20)
+
+typedef struct ServerRequest {
+    uint32_t magic;     // ServerMagic
+    uint32_t argc;      // Number of arguments, after the working directory
+    uint32_t size;      // Size of the strings that follow, including their nuls
+} ServerRequest;
+
+// Serve compile requests on the socket at path, until killed.
+// A socket already at path is replaced, but any other file there is an error.
+// Only this user may connect to the socket.
+// Each is compiled in a process of its own, forked from this one, so whatever
+// this process has set up beforehand is shared by all, and nothing else is.
+// compile is called in that process with the request's arguments and returns the exit code.
+// Return (with an error message) only if the socket cannot be set up.
+int serverRun(char *path, int (*compile)(int argc, char **argv));
+
+#endif
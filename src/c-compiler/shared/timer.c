@@ -7,11 +7,13 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "timer.h"
 
 size_t timerCurrent = TimerCount;
 uint64_t timerStamp = 0;
 uint64_t timers[TimerCount];
+uint32_t counters[CounterCount];
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
 #include <Windows.h>
@@ -29,8 +31,8 @@ uint64_t timerTick() {
 #include <time.h>
 uint64_t timerGet() {
     struct timespec tp;
-    clock_gettime(CLOCK_REALTIME, &tp);
-    return (uint64_t)tp.tv_nsec;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t)tp.tv_sec * 1000000000 + (uint64_t)tp.tv_nsec;
 }
 uint64_t timerTick() {
     return 1000000000;
@@ -60,6 +62,16 @@ double timerSummary() {
     return (double)total / timerTick();
 }
 
+void timerReset() {
+    memset(timers, 0, sizeof(timers));
+    memset(counters, 0, sizeof(counters));
+    timerCurrent = TimerCount;
+}
+
+void timerCount(size_t aCounter) {
+    ++counters[aCounter];
+}
+
 void timerPrint() {
     printf("Compile stage timing benchmarks (secs):\n");
     printf("  LLVM setup: %.6g\n", timerGetSecs(SetupTimer));
@@ -71,5 +83,7 @@ void timerPrint() {
     printf("  Verify:     %.6g\n", timerGetSecs(VerifyTimer));
     printf("  Optimize:   %.6g\n", timerGetSecs(OptTimer));
     printf("  Codegen:    %.6g\n", timerGetSecs(CodeGenTimer));
+    if (counters[CacheHitCounter] + counters[CacheMissCounter])
+        printf("  Obj cache:  %u hits, %u misses\n", counters[CacheHitCounter], counters[CacheMissCounter]);
     puts("");
 }
\ No newline at end of file
@@ -24,6 +24,13 @@ enum Timers {
     TimerCount
 };
 
+// Event counts reported along with the timers
+enum Counters {
+    CacheHitCounter,
+    CacheMissCounter,
+    CounterCount
+};
+
 // Start timing ticks for a specific timer
 void timerBegin(size_t aTimer);
 
@@ -36,6 +43,12 @@ double timerGetSecs(size_t aTimer);
 // Get the summary of all timers in seconds
 double timerSummary();
 
+// Clear all timers and counters, with none running
+void timerReset();
+
+// Count one occurrence of an event
+void timerCount(size_t aCounter);
+
 // Print out all timers
 void timerPrint();
 
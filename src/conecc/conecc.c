@@ -0,0 +1,122 @@
+/** conecc: thin client for a Cone compile server (conec --serve)
+ * @file
+ *
+ * Takes the same arguments as conec. The compile is run by the server
+ * listening on the socket named by CONEC_SERVER, in this working directory
+ * and with this process's stdin, stdout and stderr, and its exit code is
+ * returned. If there is no server to connect to, conec is run instead.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "shared/server.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Connect to the server's socket, or return -1
+static int conecConnect(char *path) {
+    struct sockaddr_un addr;
+    int sock;
+    if (!path || strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+        return -1;
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Send the request header, passing stdin, stdout and stderr along with it
+static int conecSendHeader(int sock, ServerRequest *req) {
+    int fds[3] = { 0, 1, 2 };
+    char control[CMSG_SPACE(sizeof(fds))];
+    struct iovec iov = { req, sizeof(ServerRequest) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    return sendmsg(sock, &msg, 0) == (ssize_t)sizeof(ServerRequest);
+}
+
+// Write all of buf, or return 0
+static int conecWrite(int sock, char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t put = write(sock, buf, len);
+        if (put < 0 && errno == EINTR)
+            continue;
+        if (put <= 0)
+            return 0;
+        buf += put;
+        len -= (size_t)put;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    char cwd[PATH_MAX];
+    int sock = conecConnect(getenv("CONEC_SERVER"));
+    if (sock < 0 || !getcwd(cwd, sizeof(cwd))) {
+        argv[0] = "conec";
+        execvp(argv[0], argv);
+        fprintf(stderr, "No compile server to connect to, and conec cannot be run\n");
+        return 1;
+    }
+
+    // The working directory, then the arguments (including conec's name)
+    ServerRequest req;
+    size_t size = strlen(cwd) + 1;
+    int i;
+    for (i = 0; i < argc; ++i)
+        size += strlen(argv[i]) + 1;
+    char *strs = malloc(size);
+    char *strp = strs;
+    strcpy(strp, cwd);
+    strp += strlen(cwd) + 1;
+    for (i = 0; i < argc; ++i) {
+        strcpy(strp, argv[i]);
+        strp += strlen(argv[i]) + 1;
+    }
+    req.magic = ServerMagic;
+    req.argc = (uint32_t)argc;
+    req.size = (uint32_t)size;
+
+    int32_t code;
+    char *codep = (char*)&code;
+    size_t got = 0;
+    if (!conecSendHeader(sock, &req) || !conecWrite(sock, strs, size)) {
+        fprintf(stderr, "Could not send the compile request\n");
+        return 1;
+    }
+    while (got < sizeof(code)) {
+        ssize_t n = read(sock, codep + got, sizeof(code) - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            fprintf(stderr, "The compile server did not reply\n");
+            return 1;
+        }
+        got += (size_t)n;
+    }
+    return code;
+}
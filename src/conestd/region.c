@@ -0,0 +1,168 @@
+/** region - Runtime support for the arena and pool regions
+ * @file
+ *
+ * Generated code allocates from both regions inline, only calling here
+ * when its fast path runs dry. All state is per-thread, so neither needs a lock.
+ *
+ * arena: A bump pointer (coneArenaNext) within the current chunk, which ends
+ * at coneArenaLimit. Arena references are never freed one at a time.
+ * coneArenaOpen() starts a new scope for arena allocations, and
+ * coneArenaClose() releases everything allocated since, all at once.
+ *
+ * pool: One free list per 16-byte size class, up to ConePoolMaxSize.
+ * Dropping a pool reference pushes its block onto the free list for its class,
+ * and allocating pops one off. Empty lists are refilled a slab at a time.
+ * Slabs are never handed back to the system.
+ *
+ * Code run in the compiler's JIT (--run) cannot reach this file's thread-local
+ * state, so it calls coneArenaAlloc(), conePoolAlloc() and conePoolDrop() instead.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#define coneThread __declspec(thread)
+#else
+#define coneThread _Thread_local
+#endif
+
+// Keep in step with genlalloc.c
+#define ConeAlign 16
+#define ConeArenaChunkSize (64 * 1024)
+#define ConePoolMaxSize 256
+#define ConePoolSlabSize (16 * 1024)
+
+static void *coneRegionMalloc(size_t size) {
+    void *memp = malloc(size);
+    if (memp == NULL) {
+        fputs("Out of memory\n", stderr);
+        abort();
+    }
+    return memp;
+}
+
+// *********************
+// Arena region
+// *********************
+
+// Header for an arena chunk, chained newest first
+typedef struct ConeArenaChunk {
+    struct ConeArenaChunk *prev;
+} ConeArenaChunk;
+#define ConeArenaHdrSize ((sizeof(ConeArenaChunk) + ConeAlign - 1) & ~(ConeAlign - 1))
+
+// What coneArenaClose() restores, allocated in the arena by coneArenaOpen()
+typedef struct ConeArenaMark {
+    char *next;
+    char *limit;
+    ConeArenaChunk *chunks;
+    struct ConeArenaMark *outer;
+} ConeArenaMark;
+
+coneThread char *coneArenaNext = NULL;
+coneThread char *coneArenaLimit = NULL;
+static coneThread ConeArenaChunk *coneArenaChunks = NULL;
+static coneThread ConeArenaMark *coneArenaMarks = NULL;
+
+// Allocate size bytes, when they do not fit in the current chunk.
+// size is a multiple of ConeAlign.
+void *coneArenaGrow(size_t size) {
+    // A large allocation gets a chunk of its own, leaving the current one to bump within
+    if (size > ConeArenaChunkSize / 4) {
+        ConeArenaChunk *chunk = (ConeArenaChunk *)coneRegionMalloc(ConeArenaHdrSize + size);
+        chunk->prev = coneArenaChunks;
+        coneArenaChunks = chunk;
+        return (char *)chunk + ConeArenaHdrSize;
+    }
+
+    ConeArenaChunk *chunk = (ConeArenaChunk *)coneRegionMalloc(ConeArenaChunkSize);
+    chunk->prev = coneArenaChunks;
+    coneArenaChunks = chunk;
+    char *memp = (char *)chunk + ConeArenaHdrSize;
+    coneArenaNext = memp + size;
+    coneArenaLimit = (char *)chunk + ConeArenaChunkSize;
+    return memp;
+}
+
+// Allocate size bytes from the arena
+void *coneArenaAlloc(size_t size) {
+    size = (size + ConeAlign - 1) & ~(ConeAlign - 1);
+    if (coneArenaNext && (size_t)(coneArenaLimit - coneArenaNext) >= size) {
+        void *memp = coneArenaNext;
+        coneArenaNext += size;
+        return memp;
+    }
+    return coneArenaGrow(size);
+}
+
+// Start a scope for arena allocations, which coneArenaClose() ends
+void coneArenaOpen() {
+    ConeArenaMark mark;
+    mark.next = coneArenaNext;
+    mark.limit = coneArenaLimit;
+    mark.chunks = coneArenaChunks;
+    mark.outer = coneArenaMarks;
+    ConeArenaMark *markp = (ConeArenaMark *)coneArenaAlloc(sizeof(ConeArenaMark));
+    *markp = mark;
+    coneArenaMarks = markp;
+}
+
+// Release everything allocated in the arena since the matching coneArenaOpen()
+void coneArenaClose() {
+    ConeArenaMark *markp = coneArenaMarks;
+    if (markp == NULL)
+        return;
+    ConeArenaMark mark = *markp;
+    while (coneArenaChunks != mark.chunks) {
+        ConeArenaChunk *prev = coneArenaChunks->prev;
+        free(coneArenaChunks);
+        coneArenaChunks = prev;
+    }
+    coneArenaNext = mark.next;
+    coneArenaLimit = mark.limit;
+    coneArenaMarks = mark.outer;
+}
+
+// *********************
+// Pool region
+// *********************
+
+coneThread void *conePoolFree[ConePoolMaxSize / ConeAlign] = { NULL };
+
+// Allocate a block of a size class whose free list is empty.
+// The blocks of size class n are (n + 1) * ConeAlign bytes.
+void *conePoolRefill(size_t sizeclass) {
+    size_t blksize = (sizeclass + 1) * ConeAlign;
+    char *slab = (char *)coneRegionMalloc(ConePoolSlabSize);
+    char *blk = slab + blksize;
+    char *end = slab + ConePoolSlabSize - blksize;
+    void **link = &conePoolFree[sizeclass];
+    while (blk <= end) {
+        *link = blk;
+        link = (void **)blk;
+        blk += blksize;
+    }
+    *link = NULL;
+    return slab;
+}
+
+// Allocate a block of a size class
+void *conePoolAlloc(size_t sizeclass) {
+    void *blk = conePoolFree[sizeclass];
+    if (blk == NULL)
+        return conePoolRefill(sizeclass);
+    conePoolFree[sizeclass] = *(void **)blk;
+    return blk;
+}
+
+// Return a block to its size class's free list
+void conePoolDrop(void *blk, size_t sizeclass) {
+    *(void **)blk = conePoolFree[sizeclass];
+    conePoolFree[sizeclass] = blk;
+}
@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+"""Benchmark: the extra compile time of keeping assembly listings (--asm).
+
+Generates programs of N functions and compiles each with and without --asm,
+at -O2. Reports the best wall-clock time of RUNS for each, and the time the
+listing adds. The listing is emitted on another thread while the object is,
+so with a second core it should add little beyond loading a copy of the module.
+Checks that --asm does not change the object.
+
+Usage: asmemit.py path/to/conec [workdir]
+"""
+
+import filecmp
+import os
+import sys
+
+from benchlib import best, compile, compiler, genchain
+
+SIZES = [500, 1000, 2000]
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+    obj, both = os.path.join(workdir, "obj"), os.path.join(workdir, "both")
+
+    print("%8s %10s %10s %10s" % ("fns", "obj(s)", "+asm(s)", "added"))
+    for n in SIZES:
+        src = genchain(os.path.join(workdir, "asmemit%d.cone" % n), n)
+        osecs = best(lambda: compile(conec, src, obj, ["-O2"], clean=True)[0])
+        bsecs = best(lambda: compile(conec, src, both, ["-O2", "--asm"], clean=True)[0])
+        for name in os.listdir(obj):
+            if not filecmp.cmp(os.path.join(obj, name), os.path.join(both, name), shallow=False):
+                sys.exit("--asm changed %s" % name)
+        print("%8d %10.4f %10.4f %9.0f%%" % (n, osecs, bsecs, (bsecs - osecs) * 100 / osecs))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,169 @@
+"""Shared scaffolding for the benchmark scripts in this directory.
+
+Each script generates the Cone programs for its scenario and measures them
+with these: reading the command line, compiling with conec and reading its
+-V 1 stage timers, linking with the system C compiler, and timing the best
+of RUNS runs. Scripts import it from their own directory.
+"""
+
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+RUNS = 3            # Best of RUNS is used for each measurement
+
+# A chain of small functions, each calling the one before it (see genchain)
+WORK0 = '''fn work0(x i32, y i32) i32
+  x + y
+
+'''
+
+WORK = '''fn work{i}(x i32, y i32) i32
+  mut acc = work{prev}(x, y)
+  mut n = 0
+  while n < 10
+    acc = acc * 3 + n
+    if acc > 100000
+      acc = acc - y
+    n = n + 1
+  acc
+
+'''
+
+WORKMAIN = '''fn main() i32
+  work{last}(1, 2) & 0x7f
+'''
+
+
+def getworkdir(pos):
+    """The work directory named by argument pos, else a new temporary one"""
+    return sys.argv[pos] if len(sys.argv) > pos else tempfile.mkdtemp()
+
+
+def usage(doc, nargs=1):
+    """Exit with the script's usage (its docstring) if it has fewer than nargs arguments"""
+    if len(sys.argv) < nargs + 1:
+        sys.exit(doc)
+
+
+def compiler(doc):
+    """For a usage of `path/to/conec [workdir]`: the compiler and work directory"""
+    usage(doc)
+    return os.path.abspath(sys.argv[1]), getworkdir(2)
+
+
+def compilers(doc):
+    """For a usage of `path/to/conec [path/to/baseline] [workdir]`: the list of
+    one or two compilers (or source trees), and the work directory"""
+    usage(doc)
+    found = [os.path.abspath(sys.argv[1])]
+    if len(sys.argv) > 2:
+        found.append(os.path.abspath(sys.argv[2]))
+    return found, getworkdir(3)
+
+
+def needcc(purpose="to link the benchmark programs"):
+    """The system C compiler, exiting if there is none"""
+    cc = shutil.which("cc")
+    if not cc:
+        sys.exit("A C compiler (cc) is needed %s" % purpose)
+    return cc
+
+
+def writefile(path, text):
+    with open(path, "w") as f:
+        f.write(text)
+    return path
+
+
+def genchain(path, nfns, fn=WORK, first=WORK0, main=WORKMAIN, vary=lambda i: {}):
+    """Write a program of nfns functions: first, then fn formatted with its
+    number i, the previous one's (prev) and any fields vary(i) returns, then
+    main, which calls the last (formatted with last)"""
+    with open(path, "w") as f:
+        f.write(first)
+        for i in range(1, nfns):
+            f.write(fn.format(i=i, prev=i - 1, **vary(i)))
+        f.write(main.format(last=nfns - 1))
+    return path
+
+
+def compile(conec, src, outdir, flags=[], clean=False, check=True):
+    """Compile src into outdir with -V 1, emptying outdir first if clean.
+    Returns the wall-clock seconds taken and conec's output."""
+    if clean:
+        shutil.rmtree(outdir, ignore_errors=True)
+        os.makedirs(outdir)
+    start = time.perf_counter()
+    out = subprocess.run([conec, src, "-V", "1", "-o", outdir] + flags,
+                         stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                         universal_newlines=True, check=check).stdout
+    return time.perf_counter() - start, out
+
+
+def timers(out, *stages):
+    """The seconds conec's -V 1 output reports for each of stages"""
+    return tuple(float(re.search(r"%s:?\s+([0-9.e+-]+)" % stage, out).group(1))
+                 for stage in stages)
+
+
+def link(cc, outdir, extra=[]):
+    """Link the objects in outdir (and any extra ones) into the program prog"""
+    exe = os.path.join(outdir, "prog")
+    subprocess.run([cc, "-no-pie", "-o", exe] + glob.glob(os.path.join(outdir, "*.o")) + extra,
+                   check=True)
+    return exe
+
+
+def build(conec, cc, src, outdir, flags=["-O3"], extra=[]):
+    """Compile src into an empty outdir and link it, returning the program"""
+    compile(conec, src, outdir, flags, clean=True)
+    return link(cc, outdir, extra)
+
+
+def best(fn):
+    """The smallest of RUNS results of fn. Where fn returns a tuple, the
+    smallest of each of its members."""
+    runs = [fn() for _ in range(RUNS)]
+    if isinstance(runs[0], tuple):
+        return tuple(min(col) for col in zip(*runs))
+    return min(runs)
+
+
+def timed(fn):
+    """The best wall-clock seconds of RUNS calls of fn, and what it last returned"""
+    secs, result = None, None
+    for _ in range(RUNS):
+        start = time.perf_counter()
+        result = fn()
+        elapsed = time.perf_counter() - start
+        secs = elapsed if secs is None else min(secs, elapsed)
+    return secs, result
+
+
+def run(exe):
+    """Run a program, returning its exit code"""
+    return subprocess.run([exe]).returncode
+
+
+def runtime(exe):
+    """The best wall-clock run time of a program, and its exit code"""
+    return timed(lambda: run(exe))
+
+
+def runall(builds):
+    """Time each (name, program) of builds in turn, yielding its name, best
+    run time and speedup over the first. All must give the same exit code."""
+    base, expect = None, None
+    for name, exe in builds:
+        secs, code = runtime(exe)
+        if expect is None:
+            base, expect = secs, code
+        elif code != expect:
+            sys.exit("The %s build behaves differently" % name)
+        yield name, secs, base / secs
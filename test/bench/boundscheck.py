@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Benchmark: loops over arrays and slices, whose indexes are bounds checked.
+
+Builds kernels that index a slice below a variable limit, a fixed-size
+array below a variable limit, and a slice below its own count, at -O3.
+Links each with the system C compiler and reports the best wall-clock run
+time of RUNS runs. If a second compiler is given, its program is timed
+alongside, e.g., to compare against a build that checks every index inside
+the loop. Both programs must produce the same exit code, which is checked.
+
+Usage: boundscheck.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+
+from benchlib import build, compilers, needcc, runall, writefile
+
+N = 1024            # Array length
+
+SOURCE = '''mut limit = {n}u32
+
+fn slice(data &mut []u32, n u32, k u32) u32
+  mut sum = 0u32
+  mut i = 0u32
+  while i < n
+    imm w = (data[i] ^ k) * 3u32 + (data[i] >> 7u32)
+    data[i] = w
+    sum = sum + w
+    i = i + 1
+  sum
+
+fn fixed(n u32, k u32) u32
+  mut data [{n}] u32 = [{zeros}]
+  mut i = 0u32
+  while i < n
+    data[i] = i * k
+    i = i + 1
+  mut sum = 0u32
+  i = 0u32
+  while i < n
+    sum = sum + (data[i] >> 3u32)
+    i = i + 1
+  sum
+
+fn counted(data &mut []u32, k u32) u32
+  mut sum = 0u32
+  mut i = 0usize
+  while i < data.len
+    sum = sum + (data[i] & k)
+    i = i + 1
+  sum
+
+fn main() i32
+  mut data [{n}] u32 = [{zeros}]
+  mut total = 0u32
+  mut k = 0u32
+  while k < 500000u32
+    imm n = limit - (k & 7u32)
+    total = total + slice(&mut data, n, k) + fixed(n, k) + counted(&mut data, k)
+    k = k + 1
+  i32[total & 0x7fu32]
+'''
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+    cc = needcc()
+    src = writefile(os.path.join(workdir, "boundscheck.cone"), SOURCE.format(n=N, zeros=", ".join(["0u32"] * N)))
+
+    print("%-10s %9s" % ("compiler", "run(s)"))
+    builds = ((name, build(conec, cc, src, os.path.join(workdir, name)))
+              for name, conec in zip(["new", "baseline"], conecs))
+    for name, secs, _ in runall(builds):
+        print("%-10s %8.3fs" % (name, secs))
+
+
+if __name__ == "__main__":
+    main()
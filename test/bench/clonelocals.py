@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Benchmark: cost of instantiating a generic function with many locals.
+
+Every local declared in a generic's body is cloned on instantiation, and every
+use of it is re-pointed to its clone (cloneDclFix). This generates programs
+whose generic function has N chained locals, compiles each and checks that
+the Analysis time per local stays roughly flat as N grows (i.e., linear cost).
+
+Usage: clonelocals.py path/to/conec [workdir]
+"""
+
+import os
+import sys
+
+from benchlib import best, compile, compiler, timers
+
+SIZES = [2000, 4000, 8000, 16000, 32000]
+MAX_GROWTH = 3.0    # Allowed ratio of per-local cost, largest vs. smallest N
+
+
+def gensource(path, nlocals):
+    with open(path, "w") as f:
+        f.write("fn big[T](x T) T\n")
+        f.write("  mut a0 = x\n")
+        for i in range(1, nlocals):
+            f.write("  mut a%d = a%d\n" % (i, i - 1))
+        f.write("  a%d\n\n" % (nlocals - 1))
+        f.write("fn main() i32\n")
+        f.write("  big[i32](3)\n")
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+
+    print("%8s %12s %14s" % ("locals", "analysis(s)", "usec/local"))
+    perlocal = []
+    for n in SIZES:
+        src = os.path.join(workdir, "clonelocals%d.cone" % n)
+        gensource(src, n)
+        secs, = best(lambda: timers(compile(conec, src, workdir)[1], "Analysis"))
+        perlocal.append(secs / n)
+        print("%8d %12.6f %14.3f" % (n, secs, secs / n * 1e6))
+
+    growth = perlocal[-1] / perlocal[0]
+    print("per-local cost growth, %d vs. %d locals: %.2fx" % (SIZES[-1], SIZES[0], growth))
+    if growth > MAX_GROWTH:
+        sys.exit("FAIL: instantiation cost is growing faster than linearly")
+    print("OK: instantiation cost grows linearly")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""Benchmark: total compile time of debug builds.
+
+Generates programs of N functions, each with several locals, a loop and a
+call, and compiles them with --debug. Reports the best wall-clock time of
+the whole compile, along with the Optimize and Codegen timers, where debug
+builds spend most of their time. If a second compiler is given, its
+timings are shown alongside, e.g., to compare against an older build.
+
+Usage: debugbuild.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+
+from benchlib import best, compile, compilers, genchain, timers
+
+SIZES = [1000, 2000, 4000]
+
+FN = '''fn work{i}(x i32, y i32) i32
+  mut acc = work{prev}(x, y)
+  imm scale = x * 3 + y
+  mut n = 0
+  while n < 10
+    acc = acc * scale + n
+    if acc > 100000
+      acc = acc - y
+    n = n + 1
+  acc
+
+'''
+
+
+def measure(conec, src, workdir):
+    secs, out = compile(conec, src, workdir, ["--debug"])
+    return (secs,) + timers(out, "Optimize", "Codegen")
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+
+    print("%8s %s" % ("fns", "  ".join("%9s %9s %9s" % ("total(s)", "opt(s)", "codegen(s)")
+                                       for _ in conecs)))
+    for n in SIZES:
+        src = genchain(os.path.join(workdir, "debugbuild%d.cone" % n), n, FN)
+        cols = ["%9.4f %9.4f %9.4f" % best(lambda: measure(conec, src, workdir)) for conec in conecs]
+        print("%8d %s" % (n, "  ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Benchmark: including the same shared file into many modules.
+
+Generates a shared source file of declarations (a global, a struct with a
+method and F functions) and a program of N modules, each of which includes
+it. Each program is compiled and its Load, Lexer and Parse timers reported.
+The main function uses an undeclared name, so that compilation stops after
+analysis. If a second compiler is given, its timings are shown alongside.
+
+Usage: includes.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+
+from benchlib import best, compile, compilers, timers
+
+# (number of including modules, functions in the shared file)
+SHAPES = [(50, 200), (200, 200), (200, 1000)]
+
+HEADER = '''// Shared declarations, included into every module
+mut shared_counter = 0
+
+struct SharedPoint
+  x i32
+  y i32
+  fn sum(self &) i32
+    x + y
+
+'''
+
+FN = '''fn shared_function_{i}(first_parameter i32, second_parameter i32) i32
+  mut point = SharedPoint[first_parameter, second_parameter]
+  shared_counter = shared_counter + {i}
+  point.x * point.y + first_parameter
+
+'''
+
+
+def gensources(workdir, nmods, nfns):
+    shared = "shared_%d" % nfns
+    with open(os.path.join(workdir, shared + ".cone"), "w") as f:
+        f.write(HEADER)
+        for i in range(nfns):
+            f.write(FN.format(i=i))
+    main = os.path.join(workdir, "includes_%d_%d.cone" % (nmods, nfns))
+    with open(main, "w") as f:
+        for m in range(nmods):
+            f.write("mod module_%d {\n  include %s\n}\n" % (m, shared))
+        f.write("fn main() i32\n  undeclared_name_stops_compile\n")
+    return main
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+
+    print("%6s %6s %s" % ("mods", "fns", "  ".join(
+        "%9s %9s %9s" % ("load(s)", "lexer(s)", "parse(s)") for _ in conecs)))
+    for nmods, nfns in SHAPES:
+        src = gensources(workdir, nmods, nfns)
+        cols = ["%9.5f %9.5f %9.5f" % best(lambda: timers(compile(conec, src, workdir, check=False)[1],
+                                                          "Load", "Lexer", "Parse"))
+                for conec in conecs]
+        print("%6d %6d %s" % (nmods, nfns, "  ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
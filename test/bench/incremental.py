@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Benchmark: rebuilding after a one-line edit, with and without --incremental.
+
+Generates programs of N functions and builds each once with --incremental,
+to fill its cache. Then one function's body is edited, and the program is
+rebuilt in full and with --incremental. Both rebuilds must link into
+programs with the same exit code. Reports the best wall-clock time of RUNS
+for each rebuild, and the units recompiled (cache misses) by the incremental one.
+Each size is measured as a release build and as a --debug build, whose
+metadata must not stop unchanged units from being reused.
+
+Usage: incremental.py path/to/conec [workdir]
+"""
+
+import os
+import re
+import shutil
+import sys
+
+from benchlib import best, compile, compiler, genchain, link, needcc, run
+
+SIZES = [500, 1000, 2000]
+MODES = [("release", []), ("debug", ["--debug"])]
+
+FN = '''fn work{i}(x i32, y i32) i32
+  mut acc = work{prev}(x, y)
+  mut n = 0
+  while n < 10
+    acc = acc * {k} + n
+    if acc > 100000
+      acc = acc - y
+    n = n + 1
+  acc
+
+'''
+
+
+def gensource(path, nfns, edited=None):
+    genchain(path, nfns, FN, vary=lambda i: {"k": 5 if i == edited else 3})
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+    cc = needcc()
+    cache = os.path.join(workdir, "cache")
+    full, incr = os.path.join(workdir, "full"), os.path.join(workdir, "incr")
+
+    def rebuild():
+        # Each run rebuilds from the cache as it was before the edit
+        shutil.rmtree(cache, ignore_errors=True)
+        gensource(src, n)
+        compile(conec, src, incr, iflags, clean=True)
+        gensource(src, n, edited=n // 2)
+        secs, out = compile(conec, src, incr, iflags)
+        return secs, int(re.search(r"(\d+) misses", out).group(1))
+
+    print("%8s %8s %10s %10s %8s" % ("fns", "mode", "full(s)", "incr(s)", "misses"))
+    for n in SIZES:
+        src = os.path.join(workdir, "incremental%d.cone" % n)
+        for mode, flags in MODES:
+            iflags = flags + ["--incremental", "--cache=" + cache]
+            gensource(src, n, edited=n // 2)
+            fsecs = best(lambda: compile(conec, src, full, flags, clean=True)[0])
+            isecs, misses = best(rebuild)
+            if run(link(cc, full)) != run(link(cc, incr)):
+                sys.exit("The incremental build behaves differently from the full one")
+            print("%8d %8s %10.4f %10.4f %8d" % (n, mode, fsecs, isecs, misses))
+
+
+if __name__ == "__main__":
+    main()
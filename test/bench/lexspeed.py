@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Benchmark: lexer throughput on large generated sources.
+
+Generates multi-megabyte programs heavy in what the lexer spends its time on:
+indentation and blank runs, line comments, long identifiers and string
+literals. Each is compiled and its Lexer timer turned into tokens/sec and
+MB/sec. The last function uses an undeclared name, so that compilation stops
+after analysis and large sources do not spend minutes in LLVM.
+If a second compiler is given, its throughput is shown alongside.
+
+Usage: lexspeed.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+import re
+
+from benchlib import best, compile, compilers, timers
+
+SIZES_MB = [2, 4, 8]
+
+FN = '''// Function number {i}: a line comment long enough to be worth skipping quickly
+fn compute_something_interesting_{i}(first_parameter_value i32, second_parameter_value i32) i32
+  // Mix the parameters together          with some padding
+  imm intermediate_result_value = first_parameter_value * second_parameter_value
+  imm descriptive_message_text = "a string literal, long enough to span several blocks \\n"
+  mut accumulated_running_total = intermediate_result_value + first_parameter_value
+  accumulated_running_total = accumulated_running_total - second_parameter_value
+  accumulated_running_total
+
+'''
+
+# Tokens in one FN, not counting comments or tokens injected by the off-side rule
+FN_TOKENS = len(re.findall(r'"[^"]*"|[A-Za-z_][A-Za-z0-9_]*|\d+|\S',
+                           re.sub(r'//[^\n]*', '', FN.format(i=0))))
+
+
+def gensource(path, megabytes):
+    ntokens = 0
+    size = 0
+    i = 0
+    with open(path, "w") as f:
+        while size < megabytes * 1000000:
+            fn = FN.format(i=i)
+            f.write(fn)
+            size += len(fn)
+            ntokens += FN_TOKENS
+            i += 1
+        f.write("fn main() i32\n  undeclared_name_stops_compile\n")
+    return ntokens, size
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+
+    print("%6s %10s %s" % ("MB", "tokens", "  ".join(
+        "%12s %8s" % ("tokens/sec", "MB/sec") for _ in conecs)))
+    for mb in SIZES_MB:
+        src = os.path.join(workdir, "lexspeed%d.cone" % mb)
+        ntokens, size = gensource(src, mb)
+        cols = []
+        for conec in conecs:
+            secs, = best(lambda: timers(compile(conec, src, workdir, check=False)[1], "Lexer"))
+            cols.append("%12.4g %8.1f" % (ntokens / secs, size / secs / 1e6))
+        print("%6d %10d %s" % (mb, ntokens, "  ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
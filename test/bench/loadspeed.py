@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Benchmark: cost of loading many module source files.
+
+Generates a program that pulls in N module files of a given size, each with
+a `mod` statement, compiles it and reports the Load timer (opening and reading
+or mapping source files) along with the Lexer timer, which pays for any
+page faults on first touching a file's text. The main function uses an undeclared
+name, so that compilation stops after analysis.
+If a second compiler is given, its timings are shown alongside.
+
+Usage: loadspeed.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+
+from benchlib import best, compile, compilers, timers
+
+# (number of module files, approximate bytes per file)
+SHAPES = [(2000, 2000), (500, 32000), (50, 512000)]
+
+FN = '''// Generated function {i}, padded out with a comment to look like real code
+fn function_number_{i}(first_parameter i32, second_parameter i32) i32
+  imm product = first_parameter * second_parameter
+  product + {i}
+
+'''
+
+
+def gensources(workdir, nmods, modsize):
+    main = os.path.join(workdir, "loadspeed_%d_%d.cone" % (nmods, modsize))
+    with open(main, "w") as f:
+        for m in range(nmods):
+            modfile = "ldmod_%d_%d" % (modsize, m)
+            f.write("mod %s\n" % modfile)
+            with open(os.path.join(workdir, modfile + ".cone"), "w") as mf:
+                size = i = 0
+                while size < modsize:
+                    fn = FN.format(i=i)
+                    mf.write(fn)
+                    size += len(fn)
+                    i += 1
+        f.write("fn main() i32\n  undeclared_name_stops_compile\n")
+    return main
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+
+    print("%6s %8s %s" % ("files", "bytes", "  ".join(
+        "%10s %10s" % ("load(s)", "lexer(s)") for _ in conecs)))
+    for nmods, modsize in SHAPES:
+        src = gensources(workdir, nmods, modsize)
+        cols = ["%10.6f %10.6f" % best(lambda: timers(compile(conec, src, workdir, check=False)[1],
+                                                      "Load", "Lexer"))
+                for conec in conecs]
+        print("%6d %8d %s" % (nmods, modsize, "  ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
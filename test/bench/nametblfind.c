@@ -0,0 +1,84 @@
+/** Microbenchmark: global name table lookup throughput
+ *
+ * Built against a compiler source tree by nametblfind.py. It interns many distinct
+ * identifier-like names (each lookup a miss that adds a name), then repeatedly
+ * looks all of them up again in a shuffled order (every lookup a hit).
+ * Names are generated up front, so only nametblFind is timed.
+ *
+ * Usage: nametblfind [names] [rounds]
+*/
+
+#include "ir/ir.h"
+#include "ir/nametbl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+// memory.c reports running out of memory through errorExit
+void errorExit(int exitcode, const char *msg, ...) {
+    va_list argptr;
+    va_start(argptr, msg);
+    vfprintf(stderr, msg, argptr);
+    va_end(argptr);
+    exit(exitcode);
+}
+
+static unsigned long long rngstate = 0x853c49e6748fea9bull;
+static unsigned rng() {
+    rngstate = rngstate * 6364136223846793005ull + 1442695040888963407ull;
+    return (unsigned)(rngstate >> 33);
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    size_t nnames = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    // Identifiers from 1 to 32 characters, mostly short like real programs.
+    // A serial number keeps every name distinct.
+    char **strs = malloc(nnames * sizeof(char*));
+    size_t *lens = malloc(nnames * sizeof(size_t));
+    size_t *order = malloc(nnames * sizeof(size_t));
+    for (size_t i = 0; i < nnames; ++i) {
+        char buf[64];
+        size_t len = rng() % 4 == 0 ? 9 + rng() % 16 : 2 + rng() % 8;
+        for (size_t c = 0; c < len; ++c)
+            buf[c] = chars[rng() % (c == 0 ? 53 : sizeof(chars) - 1)];
+        len += sprintf(buf + len, "%zx", i);
+        strs[i] = malloc(len + 1);
+        memcpy(strs[i], buf, len + 1);
+        lens[i] = len;
+        order[i] = i;
+    }
+    for (size_t i = nnames - 1; i > 0; --i) {
+        size_t j = rng() % (i + 1);
+        size_t t = order[i]; order[i] = order[j]; order[j] = t;
+    }
+
+    nametblInit();
+
+    double start = now();
+    for (size_t i = 0; i < nnames; ++i)
+        nametblFind(strs[i], lens[i]);
+    double misssecs = now() - start;
+
+    size_t check = 0;
+    start = now();
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < nnames; ++i)
+            check += nametblFind(strs[order[i]], lens[order[i]])->namesz;
+    double hitsecs = now() - start;
+
+    printf("%zu names: miss %.2f Mlookups/sec, hit %.2f Mlookups/sec (%zu)\n", nnames,
+        nnames / misssecs / 1e6, (double)nnames * rounds / hitsecs / 1e6, check);
+    return 0;
+}
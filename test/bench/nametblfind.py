@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""Benchmark: global name table lookup throughput (nametblFind).
+
+Builds nametblfind.c against a compiler source tree's name table and memory
+allocator, then reports how many lookups per second it does when interning
+new names (misses) and when finding names already interned (hits), for
+tables of several sizes. If a second source tree is given (e.g., a checkout
+of an earlier commit), its throughput is shown alongside.
+Needs a C compiler (CC, default cc) and llvm-config for the LLVM headers.
+
+Usage: nametblfind.py path/to/src/c-compiler [path/to/baseline/src/c-compiler] [workdir]
+"""
+
+import os
+import re
+import subprocess
+
+from benchlib import RUNS, compilers
+
+SIZES = [10000, 100000, 1000000]
+ROUNDS = 20         # Hit lookups are of every name, ROUNDS times over
+
+DRIVER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "nametblfind.c")
+
+
+def build(srcdir, exe):
+    llvmflags = subprocess.run(["llvm-config", "--cflags"], stdout=subprocess.PIPE,
+                               universal_newlines=True, check=True).stdout.split()
+    llvmflags = [f for f in llvmflags if not f.startswith("-std=")]
+    subprocess.run([os.environ.get("CC", "cc"), "-O2", "-fcommon", "-I" + srcdir] + llvmflags +
+                   [DRIVER, os.path.join(srcdir, "ir", "nametbl.c"),
+                    os.path.join(srcdir, "shared", "memory.c"), "-o", exe], check=True)
+
+
+def throughput(exe, nnames):
+    runs = []
+    for _ in range(RUNS):
+        out = subprocess.run([exe, str(nnames), str(ROUNDS)], stdout=subprocess.PIPE,
+                             universal_newlines=True, check=True).stdout
+        m = re.search(r"miss ([0-9.]+) .* hit ([0-9.]+)", out)
+        runs.append((float(m.group(1)), float(m.group(2))))
+    return max(r[0] for r in runs), max(r[1] for r in runs)
+
+
+def main():
+    srcdirs, workdir = compilers(__doc__)
+
+    exes = []
+    for i, srcdir in enumerate(srcdirs):
+        exes.append(os.path.join(workdir, "nametblfind%d" % i))
+        build(srcdir, exes[-1])
+
+    print("%8s %s" % ("names", "  ".join(
+        "%12s %12s" % ("miss Mops/s", "hit Mops/s") for _ in exes)))
+    for n in SIZES:
+        cols = ["%12.2f %12.2f" % throughput(exe, n) for exe in exes]
+        print("%8d %s" % (n, "  ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
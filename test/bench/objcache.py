@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""Benchmark: compile time with the object cache, cold and warm.
+
+Generates programs of N small functions and compiles each three ways: with
+no cache, with an empty cache directory (a miss, which also fills it), and
+again with that cache (a hit, which skips optimization and code generation).
+The object copied from the cache must be identical to the one generated.
+Reports the best wall-clock time of RUNS for each, in release builds.
+
+Usage: objcache.py path/to/conec [workdir]
+"""
+
+import filecmp
+import glob
+import os
+import shutil
+import sys
+
+from benchlib import best, compile, compiler, genchain
+
+SIZES = [500, 1000, 2000]
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+    cache = os.path.join(workdir, "cache")
+    plain, cached = os.path.join(workdir, "plain"), os.path.join(workdir, "cached")
+
+    def cold():
+        shutil.rmtree(cache, ignore_errors=True)
+        return compile(conec, src, cached, ["--cache=" + cache], clean=True)[0]
+
+    print("%8s %10s %10s %10s" % ("fns", "none(s)", "miss(s)", "hit(s)"))
+    for n in SIZES:
+        src = genchain(os.path.join(workdir, "objcache%d.cone" % n), n)
+        nsecs = best(lambda: compile(conec, src, plain, clean=True)[0])
+        msecs = best(cold)
+        hsecs = best(lambda: compile(conec, src, cached, ["--cache=" + cache], clean=True)[0])
+        for obj in glob.glob(os.path.join(plain, "*.o")):
+            if not filecmp.cmp(obj, os.path.join(cached, os.path.basename(obj)), shallow=False):
+                sys.exit("The cached object differs from the generated one")
+        print("%8d %10.4f %10.4f %10.4f" % (n, nsecs, msecs, hsecs))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Benchmark: run time of numeric Cone programs at each optimization level.
+
+Compiles a few tight numeric kernels at -O0, -O1, -O2, -O3, -Os and -Oz,
+links each with the system C compiler and reports the best wall-clock run
+time of RUNS runs, with the speedup over -O0. Every level must produce the
+same exit code, which is checked. Kernels:
+  array   An update-and-sum pass over an array slice (vectorizable)
+  hash    Integer mixing in nested loops, carried across iterations
+  float   A floating point recurrence (not vectorizable without fast-math)
+
+Usage: optlevels.py path/to/conec [workdir]
+"""
+
+import os
+
+from benchlib import build, compiler, needcc, runall, writefile
+
+LEVELS = ["0", "1", "2", "3", "s", "z"]
+N = 1024            # Array length for the array kernel
+
+ARRAY = '''fn fill(data &mut []u32)
+  mut i = 0u32
+  while i < {n}u32
+    data[i] = i * 2654435761u32
+    i = i + 1
+
+fn pass(data &mut []u32, k u32) u32
+  mut sum = 0u32
+  mut i = 0u32
+  while i < {n}u32
+    imm v = data[i]
+    imm w = (v ^ k) * 3u32 + (v >> 7u32)
+    data[i] = w
+    sum = sum + w
+    i = i + 1
+  sum
+
+fn main() i32
+  mut data [{n}] u32 = [{zeros}]
+  fill(&mut data)
+  mut total = 0u32
+  mut k = 0u32
+  while k < 200000u32
+    total = total + pass(&mut data, k)
+    k = k + 1
+  i32[total & 0x7fu32]
+'''
+
+HASH = '''fn mix(h u64, v u64) u64
+  imm x = (h ^ v) * 11400714819323198485u64
+  x ^ (x >> 29u64)
+
+fn main() i32
+  mut h = 1u64
+  mut i = 0u64
+  while i < 20000u64
+    mut j = 0u64
+    while j < 10000u64
+      h = mix(h, i + j)
+      j = j + 1
+    i = i + 1
+  i32[h & 0x7fu64]
+'''
+
+FLOAT = '''fn step(x f64, c f64) f64
+  x * x * 0.25 + c
+
+fn main() i32
+  mut total f64 = 0.
+  mut k = 0
+  while k < 2000
+    mut x f64 = 0.
+    imm c = f64[k] * 0.0005
+    mut i = 0
+    while i < 50000
+      x = step(x, c)
+      i = i + 1
+    total = total + x
+    k = k + 1
+  i32[total] & 0x7f
+'''
+
+KERNELS = [
+    ("array", ARRAY.format(n=N, zeros=", ".join(["0u32"] * N))),
+    ("hash", HASH),
+    ("float", FLOAT),
+]
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+    cc = needcc()
+
+    def builds(name, src):
+        for level in LEVELS:
+            outdir = os.path.join(workdir, "%s-O%s" % (name, level))
+            yield "%s -O%s" % (name, level), build(conec, cc, src, outdir, ["-O" + level])
+
+    print("%-8s %s" % ("kernel", " ".join("%9s %6s" % ("-O" + lvl, "") for lvl in LEVELS)))
+    for name, source in KERNELS:
+        src = writefile(os.path.join(workdir, "%s.cone" % name), source)
+        cols = ["%8.3fs %5.1fx" % (secs, speedup) for _, secs, speedup in runall(builds(name, src))]
+        print("%-8s %s" % (name, " ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
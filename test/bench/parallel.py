@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Benchmark: optimization and code generation spread over several jobs.
+
+Generates programs of N functions, each with a loop and a run of arithmetic,
+calling the function before it. Each is compiled with --jobs=1 and with
+every other job count listed, and the Optimize plus Codegen timers are
+reported with the speedup over one job. With several jobs, the partition
+objects are linked together and the program's exit code is checked against
+the single-job build, if a C compiler is found to link with.
+
+Usage: parallel.py path/to/conec [jobs,jobs,...] [workdir]
+"""
+
+import os
+import shutil
+import sys
+
+from benchlib import best, compile, genchain, getworkdir, link, run, timers, usage
+
+SIZES = [250, 500, 1000]
+JOBS = [2, 4, 8]
+
+FN = '''fn work{i}(x i32) i32
+  mut acc = work{prev}(x)
+  mut n = 0
+  while n < 20
+    acc = acc * 3 + n
+    acc = acc ^ (acc >> 5)
+    n = n + 1
+  acc & 0xffff
+
+'''
+
+FIRST = '''fn work0(x i32) i32
+  x + 1
+
+'''
+
+MAIN = '''fn main() i32
+  work{last}(7) & 0x7f
+'''
+
+
+def compile_secs(conec, src, outdir, jobs):
+    out = compile(conec, src, outdir, ["-j", str(jobs)], clean=True)[1]
+    return sum(timers(out, "Optimize", "Codegen"))
+
+
+def main():
+    usage(__doc__)
+    conec = os.path.abspath(sys.argv[1])
+    jobs = [int(j) for j in sys.argv[2].split(",")] if len(sys.argv) > 2 else JOBS
+    workdir = getworkdir(3)
+    cc = shutil.which("cc")
+
+    print("%8s %10s %s" % ("fns", "1 job(s)", " ".join("%10s %7s" % ("%d jobs" % j, "speedup")
+                                                       for j in jobs)))
+    for n in SIZES:
+        src = genchain(os.path.join(workdir, "parallel%d.cone" % n), n, FN, FIRST, MAIN)
+        outdir = os.path.join(workdir, "j1")
+        base = best(lambda: compile_secs(conec, src, outdir, 1))
+        expect = run(link(cc, outdir)) if cc else None
+        cols = []
+        for j in jobs:
+            outdir = os.path.join(workdir, "j%d" % j)
+            secs = best(lambda: compile_secs(conec, src, outdir, j))
+            if cc and run(link(cc, outdir)) != expect:
+                sys.exit("Program built with %d jobs behaves differently" % j)
+            cols.append("%10.4f %6.2fx" % (secs, base / secs))
+        print("%8d %10.4f %s" % (n, base, " ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
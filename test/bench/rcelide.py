@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Benchmark: rc references copied from local to local and passed down calls.
+
+Builds a kernel whose functions copy an rc reference into locals and pass
+each copy on as its last use, at -O3. Without moves, every copy adds to
+the reference's counter and every local's end of scope subtracts from it
+(and tests for zero). Links with the system C compiler and reports the best
+wall-clock run time of RUNS runs. If a second compiler is given, its program
+is timed alongside, e.g., to compare against a build that aliases every copy.
+Both programs must produce the same exit code, which is checked.
+
+Usage: rcelide.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+
+from benchlib import build, compilers, needcc, runall, writefile
+
+ITERATIONS = 50000000
+
+SOURCE = '''fn leaf(r &rc mut u32, k u32) u32
+  imm v = *r ^ k
+  *r = v * 3u32 + 1u32
+  v
+
+fn mid(r &rc mut u32, k u32) u32
+  imm s = r
+  leaf(s, k)
+
+fn top(r &rc mut u32, k u32) u32
+  imm a = r
+  imm b = a
+  mid(b, k + 1u32) + mid(a, k)
+
+fn main() i32
+  imm box = &rc mut 1u32
+  mut total = 0u32
+  mut k = 0u32
+  while k < {iterations}u32
+    total = total + top(box, k)
+    k = k + 1
+  i32[total & 0x7fu32]
+'''
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+    cc = needcc()
+    src = writefile(os.path.join(workdir, "rcelide.cone"), SOURCE.format(iterations=ITERATIONS))
+
+    print("%-10s %9s" % ("compiler", "run(s)"))
+    builds = ((name, build(conec, cc, src, os.path.join(workdir, name)))
+              for name, conec in zip(["new", "baseline"], conecs))
+    for name, secs, _ in runall(builds):
+        print("%-10s %8.3fs" % (name, secs))
+
+
+if __name__ == "__main__":
+    main()
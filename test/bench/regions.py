@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Benchmark: request-scoped allocations in the so, pool and arena regions.
+
+Builds the same kernel three ways, differing only in the region of the
+references it allocates: so (malloc and free), pool (per-size-class free
+lists) and arena (bump allocation, released once per request). Each request
+allocates 64 small values, each handed to a recursive call the optimizer
+cannot see through, and drops or abandons them. Links each with the system
+C compiler and the region runtime (src/conestd/region.c), and reports the
+best wall-clock run time of RUNS runs, with the speedup over so. All three
+must produce the same exit code, which is checked.
+
+Usage: regions.py path/to/conec [workdir]
+"""
+
+import os
+import subprocess
+
+from benchlib import build, compiler, needcc, runall, writefile
+
+REQUESTS = 1000000
+
+SOURCE = '''extern
+  fn coneArenaOpen()
+  fn coneArenaClose()
+
+struct Item
+  key u32
+  val u32
+  next u32
+
+fn make(k u32) &{region} Item
+  &{region} Item[k, k * 7u32, k + 1u32]
+
+fn look(item &Item, d u32) u32
+  if d == 0u32
+    return (*item).val
+  (look(item, d - 1u32) * 31u32) ^ (*item).next
+
+fn use(item &{region} Item) u32
+  look(&*item, (*item).key & 1u32)
+
+fn request(id u32) u32
+  mut sum = 0u32
+  mut k = 0u32
+  while k < 64u32
+    sum = sum + use(make(id + k))
+    k = k + 1
+  sum
+
+fn main() i32
+  mut total = 0u32
+  mut id = 0u32
+  while id < {requests}u32
+    coneArenaOpen()
+    total = total + request(id)
+    coneArenaClose()
+    id = id + 1
+  i32[total & 0x7fu32]
+'''
+
+REGIONS = ["so", "pool", "arena"]
+RUNTIME = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "src", "conestd", "region.c")
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+    cc = needcc()
+    regionobj = os.path.join(workdir, "region.o")
+    subprocess.run([cc, "-O2", "-c", RUNTIME, "-o", regionobj], check=True)
+
+    def builds():
+        for region in REGIONS:
+            src = writefile(os.path.join(workdir, "%s.cone" % region),
+                            SOURCE.format(region=region, requests=REQUESTS))
+            yield region, build(conec, cc, src, os.path.join(workdir, region), extra=[regionobj])
+
+    print("%-8s %9s %7s" % ("region", "run(s)", "speedup"))
+    for region, secs, speedup in runall(builds()):
+        print("%-8s %8.3fs %6.2fx" % (region, secs, speedup))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Benchmark: running a program with --run versus compile, link and exec.
+
+Generates programs of N small functions, called in a chain from main, and
+times the two ways of running them from source: conec --run, which
+JIT-compiles in memory, and conec writing an object that the system C
+compiler links before the program is executed. Both must give the same
+exit code. Reports the best wall-clock time of RUNS for each, in debug and
+release builds.
+
+Usage: runmode.py path/to/conec [workdir]
+"""
+
+import os
+import subprocess
+import sys
+
+from benchlib import build, compiler, genchain, needcc, run, timed
+
+SIZES = [10, 500, 2000]
+
+FN = '''fn step{i}(x i32) i32
+  mut acc = step{prev}(x)
+  if acc > 1000
+    acc = acc - 999
+  acc + {i}
+
+'''
+
+FIRST = '''fn step0(x i32) i32
+  x
+
+'''
+
+MAIN = '''fn main() i32
+  step{last}(1) & 0x7f
+'''
+
+
+def jit(conec, src, flags):
+    return subprocess.run([conec, src, "--run"] + flags,
+                          stderr=subprocess.DEVNULL).returncode
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+    cc = needcc("for the compile, link and exec path")
+    outdir = os.path.join(workdir, "aot")
+
+    print("%8s %8s %10s %14s" % ("fns", "build", "--run(s)", "obj+link(s)"))
+    for n in SIZES:
+        src = genchain(os.path.join(workdir, "runmode%d.cone" % n), n, FN, FIRST, MAIN)
+        for mode, flags in (("debug", ["--debug"]), ("release", [])):
+            jsecs, jcode = timed(lambda: jit(conec, src, flags))
+            asecs, acode = timed(lambda: run(build(conec, cc, src, outdir, flags)))
+            if jcode != acode:
+                sys.exit("--run gives exit code %d, the linked program %d" % (jcode, acode))
+            print("%8d %8s %10.4f %14.4f" % (n, mode, jsecs, asecs))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Benchmark: many tiny compiles, with conec and through a compile server.
+
+Starts conec --serve on a socket in the work directory, then compiles the
+same tiny program COMPILES times with conec and with the conecc client, in
+debug and release builds. Reports the mean wall-clock time per compile of
+each, and checks that both give identical objects.
+
+Usage: server.py path/to/conec path/to/conecc [workdir]
+"""
+
+import filecmp
+import os
+import subprocess
+import sys
+import time
+
+from benchlib import getworkdir, usage, writefile
+
+COMPILES = 200
+
+SOURCE = '''fn inc(n i32) i32
+  n + 1
+
+fn main() i32
+  mut i = 0
+  while i < 10
+    i = inc(i)
+  i
+'''
+
+
+def percompile(cmd, env):
+    start = time.perf_counter()
+    for _ in range(COMPILES):
+        subprocess.run(cmd, env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, check=True)
+    return (time.perf_counter() - start) / COMPILES
+
+
+def main():
+    usage(__doc__, 2)
+    conec, conecc = os.path.abspath(sys.argv[1]), os.path.abspath(sys.argv[2])
+    workdir = getworkdir(3)
+    src = writefile(os.path.join(workdir, "tiny.cone"), SOURCE)
+    sock = os.path.join(workdir, "conec.sock")
+    server = subprocess.Popen([conec, "--serve=" + sock])
+    try:
+        while not os.path.exists(sock):
+            time.sleep(0.01)
+        env = dict(os.environ, CONEC_SERVER=sock)
+        print("%8s %10s %10s" % ("build", "conec(ms)", "conecc(ms)"))
+        for build, flags in (("debug", ["--debug"]), ("release", [])):
+            direct, served = os.path.join(workdir, "direct"), os.path.join(workdir, "served")
+            os.makedirs(direct, exist_ok=True)
+            os.makedirs(served, exist_ok=True)
+            dsecs = percompile([conec, src, "-o", direct] + flags, env)
+            ssecs = percompile([conecc, src, "-o", served] + flags, env)
+            for obj in os.listdir(direct):
+                if not filecmp.cmp(os.path.join(direct, obj), os.path.join(served, obj), shallow=False):
+                    sys.exit("The server's %s differs from conec's" % obj)
+            print("%8s %10.2f %10.2f" % (build, dsecs * 1000, ssecs * 1000))
+    finally:
+        server.kill()
+
+
+if __name__ == "__main__":
+    main()
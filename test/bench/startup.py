@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Benchmark: fixed startup cost of compiling a trivial program.
+
+Compiles a one-function program many times and reports the best and median
+wall-clock time of the whole process, along with the best Setup (LLVM setup)
+and Parse timers. The Parse timer includes building the name table, keywords
+and core library, which dominate it for a trivial program.
+If a second compiler is given, its timings are shown alongside.
+
+Where named pipes are supported, it also reports the best time to first
+token: from starting the compiler until it opens the (empty) program to lex
+it. That covers loading the executable, LLVM setup and the core library. The
+program is a pipe, so the benchmark learns the moment it is opened.
+
+Usage: startup.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+import statistics
+import subprocess
+import time
+
+from benchlib import compile, compilers, timers, writefile
+
+RUNS = 50
+
+PROGRAM = '''fn main() i32
+  0
+'''
+
+
+def measure(conec, src, workdir):
+    walls, setups, parses = [], [], []
+    for _ in range(RUNS):
+        wall, out = compile(conec, src, workdir)
+        setup, parse = timers(out, "LLVM setup", "Parse")
+        walls.append(wall)
+        setups.append(setup)
+        parses.append(parse)
+    return min(walls), statistics.median(walls), min(setups), min(parses)
+
+
+def firsttoken(conec, fifo, workdir):
+    best = None
+    for _ in range(RUNS):
+        start = time.perf_counter()
+        proc = subprocess.Popen([conec, fifo, "-o", workdir],
+                                stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        f = open(fifo, "w")    # Blocks until the compiler opens the program
+        secs = time.perf_counter() - start
+        proc.kill()
+        proc.wait()
+        f.close()
+        best = secs if best is None else min(best, secs)
+    return best
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+    src = writefile(os.path.join(workdir, "startup.cone"), PROGRAM)
+
+    fifo = None
+    if hasattr(os, "mkfifo"):
+        fifo = os.path.join(workdir, "empty.cone")
+        if not os.path.exists(fifo):
+            os.mkfifo(fifo)
+
+    print("%-40s %10s %10s %10s %10s %10s" % ("compiler", "best(ms)", "median(ms)", "setup(ms)",
+                                              "parse(ms)", "1st tok(ms)"))
+    for conec in conecs:
+        best, median, setup, parse = measure(conec, src, workdir)
+        first = firsttoken(conec, fifo, workdir) * 1e3 if fifo else float("nan")
+        print("%-40s %10.3f %10.3f %10.3f %10.3f %10.3f" % (conec[-40:], best * 1e3, median * 1e3,
+                                                           setup * 1e3, parse * 1e3, first))
+
+
+if __name__ == "__main__":
+    main()
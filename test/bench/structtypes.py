@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Benchmark: cost of checking and generating many structural types.
+
+Reference, array-reference and array types are written out afresh at every
+use, so each function below declares the same handful of structural types
+again and passes its parameters on to the previous function. This generates
+programs of N such functions, compiles each and reports the Analysis and Gen
+timers. If a second compiler is given, its timings are shown alongside.
+
+Usage: structtypes.py path/to/conec [path/to/baseline-conec] [workdir]
+"""
+
+import os
+
+from benchlib import best, compile, compilers, timers
+
+SIZES = [1000, 2000, 4000, 8000]
+
+
+def genfn(f, i):
+    f.write("fn fn%d(p &mut S, q &[] i32, r & &mut S) &mut S\n" % i)
+    if i == 0:
+        f.write("  imm t &mut S = p\n")
+    else:
+        f.write("  imm t &mut S = fn%d(p, q, r)\n" % (i - 1))
+    f.write("  mut u &[] i32 = q\n")
+    f.write("  mut v [4] i32 = p.a\n")
+    f.write("  mut w & &mut S = r\n")
+    f.write("  u = q\n")
+    f.write("  w = r\n")
+    f.write("  t\n\n")
+
+
+def gensource(path, nfns):
+    with open(path, "w") as f:
+        f.write("struct S\n  x i32\n  a [4] i32\n\n")
+        for i in range(nfns):
+            genfn(f, i)
+        f.write("fn main() i32\n")
+        f.write("  mut s = S[1, [1, 2, 3, 4]]\n")
+        f.write("  mut arr = [1, 2, 3, 4]\n")
+        f.write("  imm ps = &mut s\n")
+        f.write("  imm x = fn%d(ps, &arr, &ps)\n" % (nfns - 1))
+        f.write("  x.x\n")
+
+
+def main():
+    conecs, workdir = compilers(__doc__)
+
+    print("%8s %s" % ("fns", "  ".join("%12s %12s" % ("analysis(s)", "gen(s)") for _ in conecs)))
+    for n in SIZES:
+        src = os.path.join(workdir, "structtypes%d.cone" % n)
+        gensource(src, n)
+        cols = ["%12.6f %12.6f" % best(lambda: timers(compile(conec, src, workdir)[1], "Analysis", "Gen"))
+                for conec in conecs]
+        print("%8d %s" % (n, "  ".join(cols)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Benchmark: a declared region's alloc and free, against so's malloc and free.
+
+Builds the same kernel twice, differing only in the region of the references
+it allocates: so (malloc and free), and a region declared in the program,
+whose alloc and free methods pop and push blocks on a fixed-size free list
+(SLAB, a C allocator linked with the program). Each request allocates 64 small
+values, each handed to a recursive call the optimizer cannot see through, and
+drops them. Links each with the system C compiler, and reports the best
+wall-clock run time of RUNS runs, with the speedup over so. Both must produce
+the same exit code, which is checked.
+
+Usage: userregion.py path/to/conec [workdir]
+"""
+
+import os
+import subprocess
+
+from benchlib import build, compiler, needcc, runall, writefile
+
+REQUESTS = 1000000
+
+SOURCE = '''extern
+  fn slabPop(size usize) *u8
+  fn slabPush(p *u8)
+
+region Slab
+  fn alloc(size usize) *u8
+    slabPop(size)
+  fn free(p *u8)
+    slabPush(p)
+
+struct Item
+  key u32
+  val u32
+  next u32
+
+fn make(k u32) &{region} Item
+  &{region} Item[k, k * 7u32, k + 1u32]
+
+fn look(item &Item, d u32) u32
+  if d == 0u32
+    return (*item).val
+  (look(item, d - 1u32) * 31u32) ^ (*item).next
+
+fn use(item &{region} Item) u32
+  look(&*item, (*item).key & 1u32)
+
+fn request(id u32) u32
+  mut sum = 0u32
+  mut k = 0u32
+  while k < 64u32
+    sum = sum + use(make(id + k))
+    k = k + 1
+  sum
+
+fn main() i32
+  mut total = 0u32
+  mut id = 0u32
+  while id < {requests}u32
+    total = total + request(id)
+    id = id + 1
+  i32[total & 0x7fu32]
+'''
+
+# A free list of 16-byte blocks, refilled from malloc a slab at a time
+SLAB = '''#include <stdlib.h>
+#define BLOCK 16
+#define SLABSIZE (16 * 1024)
+static void *freelist = NULL;
+void *slabPop(size_t size) {
+    if (size > BLOCK)
+        return malloc(size);
+    if (freelist == NULL) {
+        char *slab = malloc(SLABSIZE);
+        for (char *blk = slab; blk < slab + SLABSIZE; blk += BLOCK) {
+            *(void **)blk = freelist;
+            freelist = blk;
+        }
+    }
+    void *blk = freelist;
+    freelist = *(void **)blk;
+    return blk;
+}
+void slabPush(void *blk) {
+    *(void **)blk = freelist;
+    freelist = blk;
+}
+'''
+
+REGIONS = ["so", "Slab"]
+
+
+def main():
+    conec, workdir = compiler(__doc__)
+    cc = needcc()
+    slabobj = os.path.join(workdir, "slab.o")
+    subprocess.run([cc, "-O2", "-c", writefile(os.path.join(workdir, "slab.c"), SLAB), "-o", slabobj],
+                   check=True)
+
+    def builds():
+        for region in REGIONS:
+            src = writefile(os.path.join(workdir, "%s.cone" % region),
+                            SOURCE.format(region=region, requests=REQUESTS))
+            yield region, build(conec, cc, src, os.path.join(workdir, region), extra=[slabobj])
+
+    print("%-8s %9s %7s" % ("region", "run(s)", "speedup"))
+    for region, secs, speedup in runall(builds()):
+        print("%-8s %8.3fs %6.2fx" % (region, secs, speedup))
+
+
+if __name__ == "__main__":
+    main()